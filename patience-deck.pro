@@ -35,10 +35,13 @@ data.files = aisleriot/cards/anglo.svg
 data.path = /usr/share/$$(NAME)/data/
 data.path = /usr/share/$$(NAME)/data/
 
+seeds.files = $$files(data/seeds/*.seeds)
+seeds.path = /usr/share/$$(NAME)/seeds/
+
 copying.files = COPYING.GPL3 \
     aisleriot/COPYING.GFDL \
     aisleriot/COPYING.GFDL1.3 \
     data/COPYING.README
 copying.path = /usr/share/$$(NAME)/
 
-INSTALLS += games api data manual figures copying
+INSTALLS += games api data manual figures seeds copying
@@ -0,0 +1,165 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+import QtQuick 2.0
+import Sailfish.Silica 1.0
+import Patience 1.0
+
+Page {
+    id: page
+
+    allowedOrientations: Orientation.All
+
+    property var placements: Patience.placementStats()
+
+    function refresh() {
+        placements = Patience.placementStats()
+        Patience.requestCallStats()
+    }
+
+    function formatHistogram(histogram) {
+        // Bucket n holds calls that took less than 2^n microseconds
+        var parts = []
+        for (var i = 0; i < histogram.length; i++) {
+            if (histogram[i] > 0)
+                parts.push("<" + Math.pow(2, i) + "µs: " + histogram[i])
+        }
+        return parts.join(", ")
+    }
+
+    onStatusChanged: if (status === PageStatus.Active) refresh()
+
+    Connections {
+        target: Patience
+        onCallStats: {
+            statsModel.clear()
+            for (var game in stats) {
+                for (var name in stats[game]) {
+                    var entry = stats[game][name]
+                    statsModel.append({
+                        "game": game,
+                        "name": name,
+                        "count": entry.count,
+                        "failures": entry.failures,
+                        "averageUsecs": entry.averageUsecs,
+                        "maxUsecs": entry.maxUsecs,
+                        "histogram": formatHistogram(entry.histogram)
+                    })
+                }
+            }
+        }
+    }
+
+    ListModel {
+        id: statsModel
+    }
+
+    SilicaListView {
+        anchors.fill: parent
+        model: statsModel
+
+        PullDownMenu {
+            MenuItem {
+                //% "Refresh"
+                text: qsTrId("patience-me-refresh")
+                onClicked: refresh()
+            }
+        }
+
+        header: Column {
+            width: page.width
+
+            PageHeader {
+                //% "Call statistics"
+                title: qsTrId("patience-he-call_stats")
+            }
+
+            Label {
+                x: Theme.horizontalPageMargin
+                width: parent.width - 2 * Theme.horizontalPageMargin
+                //% "%n moves shown before engine accepted them, average %1 ms, longest %2 ms"
+                text: qsTrId("patience-la-placement_stats_accepted", placements.accepted.count)
+                    .arg(placements.accepted.averageMsecs).arg(placements.accepted.maxMsecs)
+                color: Theme.secondaryHighlightColor
+                font.pixelSize: Theme.fontSizeSmall
+                wrapMode: Text.Wrap
+            }
+
+            Label {
+                x: Theme.horizontalPageMargin
+                width: parent.width - 2 * Theme.horizontalPageMargin
+                //% "%n moves rolled back, average %1 ms, longest %2 ms"
+                text: qsTrId("patience-la-placement_stats_rolled_back", placements.rolledBack.count)
+                    .arg(placements.rolledBack.averageMsecs).arg(placements.rolledBack.maxMsecs)
+                color: Theme.secondaryHighlightColor
+                font.pixelSize: Theme.fontSizeSmall
+                wrapMode: Text.Wrap
+            }
+        }
+
+        section {
+            property: "game"
+            delegate: SectionHeader {
+                text: section
+            }
+        }
+
+        delegate: ListItem {
+            contentHeight: column.height + Theme.paddingMedium
+
+            Column {
+                id: column
+
+                x: Theme.horizontalPageMargin
+                width: parent.width - 2 * Theme.horizontalPageMargin
+                anchors.verticalCenter: parent.verticalCenter
+
+                Label {
+                    text: name
+                    width: parent.width
+                    truncationMode: TruncationMode.Fade
+                }
+
+                Label {
+                    //% "%n calls, %1 failed, average %2 µs, longest %3 µs"
+                    text: qsTrId("patience-la-call_stats_summary", count)
+                        .arg(failures).arg(averageUsecs).arg(maxUsecs)
+                    color: Theme.secondaryColor
+                    font.pixelSize: Theme.fontSizeSmall
+                    width: parent.width
+                    wrapMode: Text.Wrap
+                }
+
+                Label {
+                    text: histogram
+                    color: Theme.secondaryColor
+                    font.pixelSize: Theme.fontSizeExtraSmall
+                    width: parent.width
+                    wrapMode: Text.Wrap
+                }
+            }
+        }
+
+        ViewPlaceholder {
+            enabled: statsModel.count === 0
+            //% "No calls recorded yet"
+            text: qsTrId("patience-la-no_call_stats")
+        }
+
+        VerticalScrollDecorator {}
+    }
+}
@@ -78,6 +78,20 @@ Page {
                 onClicked: pageStack.push(Qt.resolvedUrl("SelectGame.qml"))
             }
 
+            MenuItem {
+                //% "Call statistics"
+                text: qsTrId("patience-me-call_stats")
+                visible: Patience.callStatsEnabled
+                onClicked: pageStack.push(Qt.resolvedUrl("CallStatsPage.qml"))
+            }
+
+            MenuItem {
+                //% "Move cards to foundations"
+                text: qsTrId("patience-me-play_to_foundations")
+                enabled: !Patience.engineFailed && Patience.state === Patience.RunningState
+                onClicked: Patience.playToFoundations()
+            }
+
             MenuItem {
                 //% "Options & Help"
                 text: qsTrId("patience-me-game_options")
@@ -130,11 +144,28 @@ Page {
                 verticalMargin: isPortrait ? Theme.paddingLarge : Theme.paddingSmall
                 maximumVerticalMargin: Theme.paddingLarge
                 highlightColor: Theme.rgba(Theme.highlightColor, Theme.opacityLow)
+                highlightTargets: Patience.highlightTargets
+                tapToMove: Patience.tapToMove
+                textureBudget: Patience.textureBudget
                 layer.enabled: pullDownMenu.active
                 Component.onCompleted: Patience.restoreSavedOrLoad("klondike.scm")
             }
         }
 
+        Button {
+            //: Moves all remaining cards to foundations at once
+            //% "Finish game"
+            text: qsTrId("patience-bt-auto_complete")
+            visible: Patience.canAutoComplete && Patience.state === Patience.RunningState
+            anchors {
+                horizontalCenter: tableContainer.horizontalCenter
+                bottom: messageBar.top
+                bottomMargin: Theme.paddingLarge
+            }
+            z: 4
+            onClicked: Patience.autoComplete()
+        }
+
         MouseArea {
             id: messageBar
 
@@ -156,7 +187,10 @@ Page {
             Label {
                 id: message
                 property string hint
-                text: hint !== "" && hintTimer.running ? hint : Patience.message
+                text: hint !== "" && hintTimer.running ? hint
+                    //% "This game can not be won anymore"
+                    : Patience.positionLost ? qsTrId("patience-la-position_lost")
+                    : Patience.message
                 color: Theme.highlightColor
                 anchors.bottom: parent.bottom
                 onTextChanged: x = 0
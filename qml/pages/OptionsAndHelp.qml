@@ -74,6 +74,79 @@ Page {
                 anchors.horizontalCenter: parent.horizontalCenter
             }
 
+            ComboBox {
+                property bool ready
+
+                //: Which kind of deals are picked for new games
+                //% "New deals"
+                label: qsTrId("patience-la-deal_filter")
+                // Deals can be picked only from a seed database
+                enabled: Patience.hasSeedDatabase
+                description: {
+                    switch (Patience.dealRating) {
+                    case Patience.EasyRating:
+                        //% "Current deal is easy"
+                        return qsTrId("patience-la-deal_easy")
+                    case Patience.MediumRating:
+                        //% "Current deal is of medium difficulty"
+                        return qsTrId("patience-la-deal_medium")
+                    case Patience.HardRating:
+                        //% "Current deal is hard"
+                        return qsTrId("patience-la-deal_hard")
+                    case Patience.UnwinnableRating:
+                        //% "Current deal can not be won"
+                        return qsTrId("patience-la-deal_unwinnable")
+                    default:
+                        //% "No rated deals to pick from for this game and options"
+                        return Patience.hasSeedDatabase ? "" : qsTrId("patience-la-no_seed_database")
+                    }
+                }
+                currentIndex: Patience.dealFilter
+                menu: ContextMenu {
+                    MenuItem {
+                        //% "Any"
+                        text: qsTrId("patience-me-any_deal")
+                    }
+                    MenuItem {
+                        //% "Winnable"
+                        text: qsTrId("patience-me-winnable_deal")
+                    }
+                    MenuItem {
+                        //% "Easy"
+                        text: qsTrId("patience-me-easy_deal")
+                    }
+                    MenuItem {
+                        //% "Medium"
+                        text: qsTrId("patience-me-medium_deal")
+                    }
+                    MenuItem {
+                        //% "Hard"
+                        text: qsTrId("patience-me-hard_deal")
+                    }
+                }
+
+                onCurrentIndexChanged: if (ready) Patience.dealFilter = currentIndex
+                Component.onCompleted: ready = true
+            }
+
+            TextSwitch {
+                //% "Show where cards can go"
+                text: qsTrId("patience-la-highlight_targets")
+                //% "Highlights all possible places as soon as a card is touched"
+                description: qsTrId("patience-la-highlight_targets_description")
+                checked: Patience.highlightTargets
+                onCheckedChanged: Patience.highlightTargets = checked
+            }
+
+            TextSwitch {
+                //% "Tap to move"
+                text: qsTrId("patience-la-tap_to_move")
+                //% "Tapping a card moves it to a foundation or onto another card when possible"
+                description: qsTrId("patience-la-tap_to_move_description")
+                checked: Patience.tapToMove
+                onCheckedChanged: Patience.tapToMove = checked
+            }
+
             SectionHeader {
                 //% "Options"
                 text: qsTrId("patience-se-game_options")
@@ -0,0 +1,205 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+#include <utime.h>
+#include "atlascache.h"
+#include "logging.h"
+
+namespace {
+
+const char Magic[4] = { 'P', 'D', 'A', 'T' };
+const quint32 Version = 2;
+const QString Suffix = QStringLiteral(".atlas");
+
+void unmapAtlas(void *data)
+{
+    // Unmaps the file as well
+    delete static_cast<QFile *>(data);
+}
+
+} // namespace
+
+Q_GLOBAL_STATIC(AtlasCache, cacheInstance)
+
+struct AtlasCache::Header {
+    char magic[4];
+    quint32 version;
+    quint64 key;
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    qint32 format;
+};
+
+AtlasCache *AtlasCache::instance()
+{
+    return cacheInstance();
+}
+
+AtlasCache::AtlasCache()
+{
+    static_assert(sizeof(Header) == 32, "Atlas cache header must not have padding");
+
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (directory.isEmpty() || !QDir().mkpath(directory + QStringLiteral("/atlases"))) {
+        qCWarning(lcTable) << "No cache directory for card atlases";
+        return;
+    }
+    m_directory = directory + QStringLiteral("/atlases");
+}
+
+bool AtlasCache::isValid() const
+{
+    return !m_directory.isEmpty();
+}
+
+bool AtlasCache::contains(const QString &svgFile, const QSize &size, QImage::Format format)
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_directory.isEmpty() && QFile::exists(path(key(svgFile, size, format)));
+}
+
+QImage AtlasCache::lookup(const QString &svgFile, const QSize &size, QImage::Format format)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_directory.isEmpty())
+        return QImage();
+
+    quint64 key = AtlasCache::key(svgFile, size, format);
+    QString path = this->path(key);
+    QFile *file = new QFile(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        return QImage();
+    }
+
+    Header header;
+    bool valid = file->read(reinterpret_cast<char *>(&header), sizeof(header)) == sizeof(header)
+        && memcmp(header.magic, Magic, sizeof(Magic)) == 0 && header.version == Version
+        && header.key == key && header.width == size.width() && header.height == size.height()
+        && header.format == format
+        && file->size() == (qint64)sizeof(Header) + (qint64)header.bytesPerLine * header.height;
+    uchar *data = valid ? file->map(sizeof(Header), file->size() - sizeof(Header)) : nullptr;
+    if (!data) {
+        qCWarning(lcTable) << "Removing broken card atlas" << path;
+        file->remove();
+        delete file;
+        return QImage();
+    }
+
+    // Most recently used files are kept when evicting
+    utime(QFile::encodeName(path).constData(), nullptr);
+
+    qCDebug(lcTable) << "Found card atlas of size" << size << "from cache";
+    // Mapping is read only, const data makes QImage copy before any write
+    return QImage(const_cast<const uchar *>(data), header.width, header.height, header.bytesPerLine,
+                  (QImage::Format)header.format, &unmapAtlas, file);
+}
+
+void AtlasCache::insert(const QString &svgFile, const QImage &image)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_directory.isEmpty() || image.isNull())
+        return;
+
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.key = key(svgFile, image.size(), image.format());
+    header.width = image.width();
+    header.height = image.height();
+    header.bytesPerLine = image.bytesPerLine();
+    header.format = image.format();
+
+    // Written to a temporary file first, readers never see partial atlases
+    QString path = this->path(header.key);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+            || file.write(reinterpret_cast<const char *>(image.constBits()), image.byteCount()) != image.byteCount()
+            || !file.commit()) {
+        qCWarning(lcTable) << "Can not write card atlas to" << path;
+        return;
+    }
+
+    qCDebug(lcTable) << "Stored card atlas of size" << image.size() << "to cache";
+    evict(path);
+}
+
+qint64 AtlasCache::totalSize()
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 total = 0;
+    if (!m_directory.isEmpty()) {
+        QDir directory(m_directory);
+        for (const QFileInfo &info : directory.entryInfoList(QStringList() << QStringLiteral("*") + Suffix, QDir::Files))
+            total += info.size();
+    }
+    return total;
+}
+
+quint64 AtlasCache::key(const QString &svgFile, const QSize &size, QImage::Format format)
+{
+    // qHash is salted per process, this must stay the same across runs
+    QFileInfo info(svgFile);
+    QByteArray data = info.absoluteFilePath().toUtf8();
+    data += QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (char c : data) {
+        hash ^= (quint8)c;
+        hash *= 0x100000001b3ULL;
+    }
+    for (quint32 value : { (quint32)size.width(), (quint32)size.height(), (quint32)format }) {
+        hash ^= value;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+QString AtlasCache::path(quint64 key) const
+{
+    return m_directory + QLatin1Char('/') + QString::number(key, 16) + Suffix;
+}
+
+void AtlasCache::evict(const QString &keep)
+{
+    QDir directory(m_directory);
+    QFileInfoList files = directory.entryInfoList(QStringList() << QStringLiteral("*") + Suffix,
+                                                  QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    for (const QFileInfo &info : files)
+        total += info.size();
+
+    // Oldest first, mapped files stay readable until they are unmapped
+    for (const QFileInfo &info : files) {
+        if (total <= MaximumSize)
+            break;
+        if (info.absoluteFilePath() == QFileInfo(keep).absoluteFilePath())
+            continue;
+        qCDebug(lcTable) << "Evicting card atlas" << info.fileName();
+        if (QFile::remove(info.absoluteFilePath()))
+            total -= info.size();
+    }
+}
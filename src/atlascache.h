@@ -0,0 +1,61 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATLASCACHE_H
+#define ATLASCACHE_H
+
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+
+/*
+ * Persistent cache of rendered card atlases.
+ *
+ * Each atlas is stored in its own file as raw pixels after a small
+ * header, so that it can be memory mapped and handed to the scene graph
+ * as is. Files are keyed by the SVG file and its modification time,
+ * the size and the pixel format. Hits touch the file and the least
+ * recently used files are removed when the cache grows over its cap.
+ */
+class AtlasCache
+{
+public:
+    static const qint64 MaximumSize = 48 * 1024 * 1024;
+
+    static AtlasCache *instance();
+
+    AtlasCache();
+
+    bool isValid() const;
+    bool contains(const QString &svgFile, const QSize &size, QImage::Format format);
+    QImage lookup(const QString &svgFile, const QSize &size, QImage::Format format);
+    void insert(const QString &svgFile, const QImage &image);
+    qint64 totalSize();
+
+private:
+    struct Header;
+
+    static quint64 key(const QString &svgFile, const QSize &size, QImage::Format format);
+    QString path(quint64 key) const;
+    void evict(const QString &keep);
+
+    QMutex m_mutex;
+    QString m_directory;
+};
+
+#endif // ATLASCACHE_H
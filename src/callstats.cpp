@@ -0,0 +1,95 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <QVariantList>
+#include "callstats.h"
+
+CallStats::Entry::Entry()
+    : count(0)
+    , failures(0)
+    , totalNsecs(0)
+    , maxNsecs(0)
+{
+    std::memset(buckets, 0, sizeof(buckets));
+}
+
+void CallStats::record(const QString &game, const char *name, qint64 nsecs, bool success)
+{
+    QHash<QByteArray, Entry> &entries = m_games[game];
+
+    // Look up without copying the name, it is copied only for new entries
+    QByteArray key = QByteArray::fromRawData(name, std::strlen(name));
+    auto it = entries.find(key);
+    if (it == entries.end())
+        it = entries.insert(QByteArray(name), Entry());
+
+    Entry &entry = it.value();
+    entry.count++;
+    if (!success)
+        entry.failures++;
+    entry.totalNsecs += nsecs;
+    entry.maxNsecs = qMax(entry.maxNsecs, quint64(nsecs));
+    entry.buckets[bucket(nsecs)]++;
+}
+
+void CallStats::clear()
+{
+    m_games.clear();
+}
+
+QVariantMap CallStats::toVariant() const
+{
+    QVariantMap games;
+    for (auto game = m_games.constBegin(); game != m_games.constEnd(); ++game) {
+        QVariantMap lambdas;
+        for (auto it = game.value().constBegin(); it != game.value().constEnd(); ++it) {
+            const Entry &entry = it.value();
+
+            // Trailing empty buckets are left out
+            int last = BucketCount - 1;
+            while (last > 0 && !entry.buckets[last])
+                last--;
+            QVariantList histogram;
+            for (int i = 0; i <= last; i++)
+                histogram.append(entry.buckets[i]);
+
+            QVariantMap map;
+            map.insert(QStringLiteral("count"), entry.count);
+            map.insert(QStringLiteral("failures"), entry.failures);
+            map.insert(QStringLiteral("totalUsecs"), entry.totalNsecs / 1000);
+            map.insert(QStringLiteral("averageUsecs"), entry.count ? entry.totalNsecs / entry.count / 1000 : 0);
+            map.insert(QStringLiteral("maxUsecs"), entry.maxNsecs / 1000);
+            map.insert(QStringLiteral("histogram"), histogram);
+            lambdas.insert(QString::fromUtf8(it.key()), map);
+        }
+        games.insert(game.key(), lambdas);
+    }
+    return games;
+}
+
+int CallStats::bucket(qint64 nsecs)
+{
+    // Bucket n holds calls that took less than 2^n microseconds
+    quint64 usecs = nsecs > 0 ? quint64(nsecs) / 1000 : 0;
+    int bucket = 0;
+    while (usecs && bucket < BucketCount - 1) {
+        usecs >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
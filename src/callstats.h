@@ -0,0 +1,57 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CALLSTATS_H
+#define CALLSTATS_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+
+/*
+ * Counts calls into Scheme and how long they took, per game and per
+ * lambda or named procedure. Latencies are collected to buckets by
+ * powers of two of microseconds. Only used on engine thread and only
+ * allocated when statistics are enabled.
+ */
+class CallStats
+{
+public:
+    static const int BucketCount = 24;
+
+    struct Entry {
+        quint64 count;
+        quint64 failures;
+        quint64 totalNsecs;
+        quint64 maxNsecs;
+        quint32 buckets[BucketCount];
+
+        Entry();
+    };
+
+    void record(const QString &game, const char *name, qint64 nsecs, bool success);
+    void clear();
+    QVariantMap toVariant() const;
+
+    static int bucket(qint64 nsecs);
+
+private:
+    QHash<QString, QHash<QByteArray, Entry>> m_games;
+};
+
+#endif // CALLSTATS_H
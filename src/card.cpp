@@ -15,8 +15,6 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <QSGSimpleRectNode>
-#include <QSGSimpleTextureNode>
 #include "table.h"
 #include "card.h"
 #include "constants.h"
@@ -25,16 +23,16 @@
 
 namespace {
 
+// See TextureRenderer for the layout of the atlas
 int getColumn(Rank rank) {
     switch (rank) {
     case RankAceHigh:
+        return 0;
     case RankJoker:
     case BlackJoker:
-        return 0;
     case RedJoker:
-        return 1;
     case CardBack:
-        return 2;
+        return 13;
     default:
         return rank-1;
     }
@@ -43,11 +41,13 @@ int getColumn(Rank rank) {
 int getRow(Rank rank, Suit suit)
 {
     switch (rank) {
-    case CardBack:
     case RankJoker:
     case BlackJoker:
+        return 0;
     case RedJoker:
-        return 4;
+        return 1;
+    case CardBack:
+        return 2;
     default:
         return suit;
     }
@@ -55,69 +55,64 @@ int getRow(Rank rank, Suit suit)
 
 } // namespace
 
-Card::Card(const CardData &card, Table *table, Slot *slot, QObject *parent)
-    : QQuickItem(slot)
-    , m_table(table)
+Card::Card(const CardData &card, Table *table)
+    : m_table(table)
+    , m_parent(nullptr)
     , m_data(card)
-    , m_dirty(true)
 {
-    setParent(parent);
-    setAcceptedMouseButtons(Qt::LeftButton);
-    setFlag(QQuickItem::ItemHasContents);
-    setSmooth(true);
-    connect(table, &Table::cardTextureUpdated, this, &Card::handleCardTextureUpdated);
 }
 
-QSGNode *Card::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+QPointF Card::position() const
 {
-    auto texture = m_table->cardTexture();
-    if (!texture) {
-        if (oldNode)
-            delete oldNode;
-        return nullptr;
-    }
+    return m_position;
+}
 
-    auto *node = static_cast<QSGSimpleTextureNode *>(oldNode);
-    if (!node || m_dirty) {
-        if (!node)
-            node = new QSGSimpleTextureNode();
-        node->setTexture(texture);
-        int column = getColumn(show() ? rank() : CardBack);
-        int row = getRow(show() ? rank() : CardBack, suit());
-        QSizeF size = m_table->cardSizeInTexture();
-        QRect rect(column * size.width(), row * size.height(), size.width(), size.height());
-        node->setSourceRect(rect);
-        m_dirty = false;
-    }
-    if (highlighted()) {
-        if (node->childCount() < 1) {
-            auto color = m_table->highlightColor();
-            auto child = new QSGSimpleRectNode(boundingRect(), color);
-            child->setFlag(QSGNode::OwnedByParent);
-            node->appendChildNode(child);
-        }
-    } else { // !highlighted()
-        if (node->childCount() > 0)
-            node->removeAllChildNodes();
+void Card::setPosition(const QPointF &position)
+{
+    if (m_position != position) {
+        m_position = position;
+        m_table->updateCard(this);
     }
-    node->setRect(boundingRect());
-    return node;
 }
 
 QSizeF Card::size() const
 {
-    return QSizeF(width(), height());
+    // All cards have the same size
+    return m_table->cardSize();
 }
 
-void Card::setSize(const QSizeF &size)
+QRectF Card::boundingRect() const
 {
-    if (width() != size.width() || height() != size.height()) {
-        m_dirty = true;
-        setWidth(size.width());
-        setHeight(size.height());
+    return QRectF(QPointF(), size());
+}
+
+QRectF Card::mapRectToItem(const QQuickItem *item, const QRectF &rect) const
+{
+    QRectF mapped = rect.translated(m_position);
+    return m_parent ? m_parent->mapRectToItem(item, mapped) : mapped;
+}
+
+QQuickItem *Card::parentItem() const
+{
+    return m_parent;
+}
+
+void Card::setParentItem(QQuickItem *parent)
+{
+    if (m_parent != parent) {
+        m_parent = parent;
+        m_table->updateCard(this);
     }
 }
 
+QRectF Card::sourceRect() const
+{
+    int column = getColumn(show() ? rank() : CardBack);
+    int row = getRow(show() ? rank() : CardBack, suit());
+    QSizeF size = m_table->cardSizeInTexture();
+    return QRectF(column * size.width(), row * size.height(), size.width(), size.height());
+}
+
 Suit Card::suit() const
 {
     return m_data.suit;
@@ -147,7 +142,7 @@ void Card::setShow(bool show)
 {
     if (m_data.show != show) {
         m_data.show = show;
-        m_dirty = true;
+        m_table->updateCard(this);
     }
 }
 
@@ -156,60 +151,9 @@ bool Card::operator==(const Card &other) const
     return m_data == other.m_data;
 }
 
-void Card::handleCardTextureUpdated()
-{
-    m_dirty = true;
-    update();
-}
-
-void Card::mousePressEvent(QMouseEvent *event)
-{
-    qCDebug(lcMouse) << event << "for" << *this;
-
-    m_table->drag(event, this);
-
-    setKeepMouseGrab(true);
-}
-
-void Card::mouseReleaseEvent(QMouseEvent *event)
-{
-    qCDebug(lcMouse) << event << "for" << *this;
-
-    auto drag = m_table->drag(event, this);
-
-    if (!drag) {
-        qCCritical(lcDrag) << "Can not handle mouse release! There is no drag ongoing!";
-        return;
-    }
-
-    drag->finish(event);
-
-    setKeepMouseGrab(false);
-}
-
-void Card::mouseMoveEvent(QMouseEvent *event)
-{
-    qCDebug(lcMouse) << event << "for" << *this;
-
-    auto drag = m_table->drag(event, this);
-
-    if (!drag) {
-        qCCritical(lcDrag) << "Can not handle mouse move! There is no drag ongoing!";
-        return;
-    }
-
-    drag->update(event);
-}
-
 Slot *Card::slot() const
 {
-    return dynamic_cast<Slot *>(parentItem());
-}
-
-bool Card::highlighted() const
-{
-    Slot *slot = this->slot();
-    return slot && slot->highlighted() && slot->top() == this;
+    return qobject_cast<Slot *>(m_parent);
 }
 
 QDebug operator<<(QDebug debug, const Card &card)
@@ -18,26 +18,27 @@
 #ifndef CARD_H
 #define CARD_H
 
-#include <QtQuick/QQuickItem>
+#include <QDebug>
+#include <QPointF>
+#include <QRectF>
 #include "enginedata.h"
-#include "drag.h"
 
-class QQuickWindow;
-class QSvgRenderer;
-class QSGTexture;
+class QQuickItem;
 class Table;
 class Slot;
-class Card : public QQuickItem
+class Card
 {
-    Q_OBJECT
-
 public:
-    Card(const CardData &card, Table *table, Slot *slot, QObject *parent = nullptr);
-
-    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *);
+    Card(const CardData &card, Table *table);
 
+    QPointF position() const;
+    void setPosition(const QPointF &position);
     QSizeF size() const;
-    void setSize(const QSizeF &size);
+    QRectF boundingRect() const;
+    QRectF mapRectToItem(const QQuickItem *item, const QRectF &rect) const;
+
+    QQuickItem *parentItem() const;
+    void setParentItem(QQuickItem *parent);
 
     Suit suit() const;
     Rank rank() const;
@@ -47,22 +48,15 @@ public:
 
     Slot *slot() const;
     CardData data() const;
+    QRectF sourceRect() const;
 
     bool operator==(const Card &other) const;
 
-private slots:
-    void handleCardTextureUpdated();
-
 private:
-    void mousePressEvent(QMouseEvent *event);
-    void mouseReleaseEvent(QMouseEvent *event);
-    void mouseMoveEvent(QMouseEvent *event);
-
-    bool highlighted() const;
-
     Table *m_table;
+    QQuickItem *m_parent;
+    QPointF m_position;
     CardData m_data;
-    bool m_dirty;
 };
 
 QDebug operator<<(QDebug debug, const Card &card);
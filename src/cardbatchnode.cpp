@@ -0,0 +1,97 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QSGTexture>
+#include <cstring>
+#include "cardbatchnode.h"
+
+namespace {
+
+// Two triangles per card
+const int VerticesPerQuad = 6;
+
+} // namespace
+
+CardBatchNode::CardBatchNode()
+    : m_geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0)
+    , m_changed(false)
+{
+    m_geometry.setDrawingMode(GL_TRIANGLES);
+    setGeometry(&m_geometry);
+    setMaterial(&m_material);
+    setOpaqueMaterial(&m_opaqueMaterial);
+    m_material.setFiltering(QSGTexture::Linear);
+    m_opaqueMaterial.setFiltering(QSGTexture::Linear);
+}
+
+QSGTexture *CardBatchNode::texture() const
+{
+    return m_material.texture();
+}
+
+void CardBatchNode::setTexture(QSGTexture *texture)
+{
+    if (m_material.texture() != texture) {
+        m_material.setTexture(texture);
+        m_opaqueMaterial.setTexture(texture);
+        markDirty(DirtyMaterial);
+    }
+}
+
+int CardBatchNode::count() const
+{
+    return m_geometry.vertexCount() / VerticesPerQuad;
+}
+
+void CardBatchNode::setCount(int count)
+{
+    if (this->count() != count) {
+        m_geometry.allocate(count * VerticesPerQuad);
+        m_changed = true;
+    }
+}
+
+void CardBatchNode::setQuad(int index, const QRectF &rect, const QRectF &sourceRect)
+{
+    QSGTexture *texture = m_material.texture();
+    if (!texture || index < 0 || index >= count())
+        return;
+
+    QRectF source = texture->convertToNormalizedSourceRect(sourceRect);
+
+    QSGGeometry::TexturedPoint2D corners[VerticesPerQuad];
+    corners[0].set(rect.left(), rect.top(), source.left(), source.top());
+    corners[1].set(rect.right(), rect.top(), source.right(), source.top());
+    corners[2].set(rect.left(), rect.bottom(), source.left(), source.bottom());
+    corners[3] = corners[2];
+    corners[4] = corners[1];
+    corners[5].set(rect.right(), rect.bottom(), source.right(), source.bottom());
+
+    QSGGeometry::TexturedPoint2D *vertices = m_geometry.vertexDataAsTexturedPoint2D() + index * VerticesPerQuad;
+    if (memcmp(vertices, corners, sizeof(corners)) != 0) {
+        memcpy(vertices, corners, sizeof(corners));
+        m_changed = true;
+    }
+}
+
+void CardBatchNode::commit()
+{
+    if (m_changed) {
+        markDirty(DirtyGeometry);
+        m_changed = false;
+    }
+}
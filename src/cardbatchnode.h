@@ -0,0 +1,53 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CARDBATCHNODE_H
+#define CARDBATCHNODE_H
+
+#include <QRectF>
+#include <QSGGeometryNode>
+#include <QSGTextureMaterial>
+
+class QSGTexture;
+
+/*
+ * Draws any number of cards from the card atlas with one draw call.
+ *
+ * Every card is a textured quad in the same geometry. Quads are set by
+ * index and the geometry is marked dirty only if a quad really changed.
+ */
+class CardBatchNode : public QSGGeometryNode
+{
+public:
+    CardBatchNode();
+
+    QSGTexture *texture() const;
+    void setTexture(QSGTexture *texture);
+
+    int count() const;
+    void setCount(int count);
+    void setQuad(int index, const QRectF &rect, const QRectF &sourceRect);
+    void commit();
+
+private:
+    QSGGeometry m_geometry;
+    QSGTextureMaterial m_material;
+    QSGOpaqueTextureMaterial m_opaqueMaterial;
+    bool m_changed;
+};
+
+#endif // CARDBATCHNODE_H
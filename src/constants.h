@@ -27,6 +27,7 @@ namespace Constants {
 extern const QString GameDirectory;
 extern const QString DataDirectory;
 extern const QString ConfPath;
+extern const QString SeedDirectory;
 };
 
 #endif // CONSTANTS_H
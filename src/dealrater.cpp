@@ -0,0 +1,73 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QMetaObject>
+#include <QThread>
+#include "dealrater.h"
+#include "engine.h"
+#include "logging.h"
+#include "seeddatabase.h"
+#include "solvercache.h"
+
+namespace {
+
+const qint64 RatingTimeLimit = 3000;
+// Keeps the transposition table at 8 MiB, hard deals need 100000 nodes
+const quint64 RatingNodeLimit = 500000;
+
+} // namespace
+
+DealRater::DealRater(QSharedPointer<Solver> solver, const SolverPosition &position,
+                     quint64 gameKey, quint32 seed)
+    : m_solver(solver)
+    , m_position(position)
+    , m_gameKey(gameKey)
+    , m_seed(seed)
+{
+}
+
+void DealRater::run()
+{
+    Solver::Limits limits;
+    limits.msecs = RatingTimeLimit;
+    limits.nodes = RatingNodeLimit;
+    // Leave a core for the user interface
+    limits.threads = qMax(1, QThread::idealThreadCount() - 1);
+
+    Solver::Result result = m_solver->solve(m_position, limits);
+    if (m_solver->isCanceled())
+        return;
+    SolverCache::instance()->insert(m_gameKey, SolverCache::positionKey(m_position), result);
+
+    SeedDatabase::Rating rating;
+    switch (result.outcome) {
+    case Solver::Solvable:
+        rating = SeedDatabase::rate(SeedDatabase::Solvable, SeedDatabase::quantise(result.nodes));
+        break;
+    case Solver::Unsolvable:
+        rating = SeedDatabase::UnwinnableRating;
+        break;
+    default:
+        // Running out of time tells nothing about the deal
+        rating = SeedDatabase::UnknownRating;
+        break;
+    }
+
+    qCDebug(lcSolver) << "Rated seed" << m_seed << "as" << rating << "after" << result.nodes << "nodes";
+    QMetaObject::invokeMethod(Engine::instance(), "handleDealRated", Qt::QueuedConnection,
+                              Q_ARG(quint32, m_seed), Q_ARG(int, rating));
+}
@@ -0,0 +1,45 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEALRATER_H
+#define DEALRATER_H
+
+#include <QRunnable>
+#include <QSharedPointer>
+#include "solver.h"
+
+/*
+ * Rates a deal with bounded time search in the background when seed
+ * database doesn't know it. Result is delivered to Engine with a queued
+ * call to handleDealRated.
+ */
+class DealRater : public QRunnable
+{
+public:
+    DealRater(QSharedPointer<Solver> solver, const SolverPosition &position,
+              quint64 gameKey, quint32 seed);
+
+    void run();
+
+private:
+    QSharedPointer<Solver> m_solver;
+    SolverPosition m_position;
+    quint64 m_gameKey;
+    quint32 m_seed;
+};
+
+#endif // DEALRATER_H
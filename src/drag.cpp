@@ -21,6 +21,7 @@
 #include "drag.h"
 #include "table.h"
 #include "card.h"
+#include "cardbatchnode.h"
 #include "slot.h"
 #include "constants.h"
 #include "logging.h"
@@ -45,8 +46,36 @@ QElapsedTimer Drag::s_doubleClickTimer;
 
 const Card *Drag::s_lastCard = nullptr;
 
+Drag::Latency Drag::s_accepted = { 0, 0, 0 };
+
+Drag::Latency Drag::s_rolledBack = { 0, 0, 0 };
+
+void Drag::Latency::record(qint64 msecs)
+{
+    count++;
+    total += msecs;
+    longest = qMax(longest, msecs);
+}
+
+QVariantMap Drag::Latency::toMap() const
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("count"), count);
+    map.insert(QStringLiteral("averageMsecs"), count > 0 ? total / count : 0);
+    map.insert(QStringLiteral("maxMsecs"), longest);
+    return map;
+}
+
+QVariantMap Drag::placementStats()
+{
+    QVariantMap stats;
+    stats.insert(QStringLiteral("accepted"), s_accepted.toMap());
+    stats.insert(QStringLiteral("rolledBack"), s_rolledBack.toMap());
+    return stats;
+}
+
 Drag::Drag(QMouseEvent *event, Table *table, Slot *slot, Card *card)
-    : QQuickItem(card)
+    : QQuickItem(table)
     , m_state(NoDrag)
     , m_id(s_count++)
     , m_mayBeADoubleClick(false)
@@ -54,27 +83,41 @@ Drag::Drag(QMouseEvent *event, Table *table, Slot *slot, Card *card)
     , m_card(card)
     , m_source(slot)
     , m_target(-1)
+    , m_placedTarget(nullptr)
 {
-    setParentItem(table);
     setX(slot->x());
     setY(slot->y());
+    setFlag(QQuickItem::ItemHasContents);
 
     auto engine = Engine::instance();
     connect(this, &Drag::doDrag, engine, &Engine::drag);
     connect(this, &Drag::doCancelDrag, engine, &Engine::cancelDrag);
     connect(this, &Drag::doCheckDrop, engine, &Engine::checkDrop);
     connect(this, &Drag::doDrop, engine, &Engine::drop);
+    connect(this, &Drag::doMove, engine, &Engine::move);
     connect(this, &Drag::doClick, engine, &Engine::click);
     connect(this, &Drag::doDoubleClick, engine, &Engine::doubleClick);
     connect(engine, &Engine::couldDrag, this, &Drag::handleCouldDrag);
     connect(engine, &Engine::couldDrop, this, &Drag::handleCouldDrop);
     connect(engine, &Engine::dropped, this, &Drag::handleDropped);
     connect(engine, &Engine::clicked, this, &Drag::handleClicked);
+    connect(table, &Table::cardTextureUpdated, this, [this] {
+        QQuickItem::update();
+    });
 
     m_mayBeADoubleClick = couldBeDoubleClick(card);
-    m_startPoint = m_lastPoint = card->mapToItem(m_table, event->pos());
+    // Mouse events are delivered to the table
+    m_startPoint = m_lastPoint = event->pos();
     m_timer.start();
 
+    if (m_table->highlightTargets()) {
+        // Known targets need not be asked again while dragging
+        m_highlights = m_table->getTargetsFor(card, slot);
+        for (Slot *target : m_highlights)
+            m_couldDrop.insert(target->id(), CanDrop);
+        m_table->highlight(m_highlights);
+    }
+
     qCDebug(lcDrag) << "Started drag of" << *card << "for" << *slot;
 }
 
@@ -82,6 +125,10 @@ Drag::~Drag()
 {
     if (m_state < Dropped)
         qCWarning(lcDrag) << "Drag was not finished or canceled when it was destroyed";
+
+    // Cards that are still being dragged do not belong to any slot
+    if (m_state == Dragging || m_state == Dropping)
+        qDeleteAll(m_cards);
 }
 
 Card *Drag::card() const
@@ -94,6 +141,28 @@ Slot *Drag::source() const
     return m_source;
 }
 
+QSGNode *Drag::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+    // Dragged cards are a small batch of their own and only this item moves
+    auto *node = static_cast<CardBatchNode *>(oldNode);
+    if (!node)
+        node = new CardBatchNode();
+
+    QList<Card *> cards;
+    for (Card *card : m_cards) {
+        if (card->parentItem() == this)
+            cards.append(card);
+    }
+
+    QSGTexture *texture = m_table->cardTexture();
+    node->setTexture(texture);
+    node->setCount(texture ? cards.count() : 0);
+    for (int i = 0; i < cards.count(); i++)
+        node->setQuad(i, cards[i]->mapRectToItem(this, cards[i]->boundingRect()), cards[i]->sourceRect());
+    node->commit();
+    return node;
+}
+
 void Drag::update(QMouseEvent *event)
 {
     if (mayBeAClick(event)) {
@@ -102,7 +171,7 @@ void Drag::update(QMouseEvent *event)
         m_state = StartingDrag;
         emit doDrag(m_id, m_source->id(), m_source->asCardData(m_card));
     } else if (m_state == Dragging) {
-        QPointF point = m_card->mapToItem(m_table, event->pos());
+        QPointF point = event->pos();
         QPointF move = point - m_lastPoint;
         setX(x() + move.x());
         setY(y() + move.y());
@@ -114,6 +183,10 @@ void Drag::update(QMouseEvent *event)
 void Drag::finish(QMouseEvent *event)
 {
     if (mayBeAClick(event)) {
+        if (!m_highlights.isEmpty())
+            m_table->highlight(nullptr);
+        if (!m_mayBeADoubleClick && tapToMove())
+            return;
         m_state = Clicked;
         if (m_mayBeADoubleClick) {
             qCDebug(lcDrag) << "Detected double click on" << *m_card;
@@ -160,7 +233,7 @@ void Drag::highlightOrDrop()
             // Found target to highlight or drop to
             if (m_state < Dropping) {
                 qCDebug(lcDrag) << "Highlighting" << target->id();
-                m_table->highlight(target);
+                highlight(target);
             } else {
                 m_table->highlight(nullptr);
                 drop(target);
@@ -174,29 +247,80 @@ void Drag::highlightOrDrop()
     } else {
         // No suitable target, remove highlights or cancel
         if (m_state < Dropping) {
-            m_table->highlight(nullptr);
+            highlight(nullptr);
         } else {
             cancel();
         }
     }
 }
 
+void Drag::highlight(Slot *slot)
+{
+    // Targets shown on press stay until the drag ends
+    if (m_highlights.isEmpty())
+        m_table->highlight(slot);
+}
+
 void Drag::drop(Slot *slot)
 {
     qCDebug(lcDrag) << "Moving from" << m_source->id() << "to" << slot->id();
-    emit doDrop(m_id, m_source->id(), slot->id(), toCardData(m_cards));
+    m_state = Committing;
+    CardList cards = toCardData(m_cards);
+    place(slot);
+    emit doDrop(m_id, m_source->id(), slot->id(), cards);
+}
+
+void Drag::place(Slot *slot)
+{
+    // Show the cards in their new place already, engine was asked about
+    // the target before and it is unlikely to change its mind
+    m_placedTarget = slot;
+    m_table->place(slot, m_cards);
+    QQuickItem::update();
+    m_commitTimer.start();
+}
+
+void Drag::rollBack()
+{
+    qint64 time = m_commitTimer.elapsed();
+    s_rolledBack.record(time);
+    qCDebug(lcDrag) << "Engine rejected move to" << m_placedTarget->id() << "after" << time << "ms,"
+                    << s_rolledBack.count << "of" << s_accepted.count + s_rolledBack.count
+                    << "placed moves rolled back";
+
+    m_table->unplace(m_placedTarget, m_cards);
+    m_placedTarget = nullptr;
+    if (m_state == Committing) {
+        // Engine puts the cards back itself only if the move fails
+        emit doCancelDrag(m_id, m_source->id(), toCardData(m_cards));
+    }
+    m_source->put(m_cards);
+    m_cards.clear();
+    QQuickItem::update();
+
+    if (!m_highlights.isEmpty())
+        m_table->highlight(nullptr);
+    m_state = Canceled;
+    deleteLater();
 }
 
 void Drag::cancel()
 {
+    // The cards are waiting for engine's answer
+    if (m_state == Committing || m_state == Moving)
+        return;
+
     qCDebug(lcDrag) << "Canceling drag of" << *m_card << "at state" << m_state;
 
     if (m_state == Dragging || m_state == Dropping) {
         emit doCancelDrag(m_id, m_source->id(), toCardData(m_cards));
         m_source->put(m_cards);
         m_cards.clear();
+        QQuickItem::update();
     }
 
+    if (!m_highlights.isEmpty())
+        m_table->highlight(nullptr);
     m_state = Canceled;
     deleteLater();
 }
@@ -211,6 +335,7 @@ void Drag::handleCouldDrag(quint32 id, int slotId, bool could)
         m_cards = m_source->take(m_card);
         for (Card *card : m_cards)
             card->setParentItem(this);
+        QQuickItem::update();
 
         checkTargets();
     }
@@ -233,10 +358,21 @@ void Drag::handleDropped(quint32 id, int slotId, bool could)
         return;
 
     if (could) {
+        if (m_placedTarget) {
+            qint64 time = m_commitTimer.elapsed();
+            s_accepted.record(time);
+            qCDebug(lcDrag) << "Engine accepted move after" << time << "ms, average is"
+                            << s_accepted.total / s_accepted.count << "ms";
+        } else {
+            m_table->store(m_cards);
+        }
         m_state = Dropped;
-        m_table->store(m_cards);
+        m_table->highlight(nullptr);
         m_cards.clear();
+        QQuickItem::update();
         deleteLater();
+    } else if (m_placedTarget) {
+        rollBack();
     } else {
         cancel();
     }
@@ -264,13 +400,31 @@ bool Drag::mayBeAClick(QMouseEvent *event)
     if (m_timer.hasExpired(styleHints->startDragTime()))
         m_state = AboutToDrag;
 
-    qreal distance = (m_startPoint - m_card->mapToItem(m_table, event->pos())).manhattanLength();
+    qreal distance = (m_startPoint - event->pos()).manhattanLength();
     if (distance >= styleHints->startDragDistance())
         m_state = AboutToDrag;
 
     return m_state == NoDrag;
 }
 
+bool Drag::tapToMove()
+{
+    if (!m_table->tapToMove())
+        return false;
+
+    Slot *target = m_table->getBestTargetFor(m_card, m_source);
+    if (!target)
+        return false;
+
+    qCDebug(lcDrag) << "Moving" << *m_card << "from" << m_source->id() << "to" << target->id();
+    m_state = Moving;
+    CardList cards = m_source->asCardData(m_card);
+    m_cards = m_source->take(m_card);
+    place(target);
+    emit doMove(m_id, m_source->id(), target->id(), cards);
+    return true;
+}
+
 bool Drag::couldBeDoubleClick(const Card *card)
 {
     qint64 time = (card == s_lastCard && s_doubleClickTimer.isValid()) ?
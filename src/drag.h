@@ -21,6 +21,7 @@
 #include <QElapsedTimer>
 #include <QPointF>
 #include <QQuickItem>
+#include <QVariantMap>
 #include "enginedata.h"
 
 class QMouseEvent;
@@ -38,16 +39,21 @@ public:
     Card *card() const;
     Slot *source() const;
 
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *);
     void update(QMouseEvent *event);
     void finish(QMouseEvent *event);
     void drop(Slot *slot);
     void cancel();
 
+    // How long engine took to answer moves that were shown placed already
+    static QVariantMap placementStats();
+
 signals:
     void doDrag(quint32 id, int slotId, const CardList &cards);
     void doCancelDrag(quint32 id, int slotId, const CardList &cards);
     void doCheckDrop(quint32 id, int startSlotId, int endSlotId, const CardList &cards);
     void doDrop(quint32 id, int startSlotId, int endSlotId, const CardList &cards);
+    void doMove(quint32 id, int startSlotId, int endSlotId, const CardList &cards);
     void doClick(quint32 id, int slotId);
     void doDoubleClick(quint32 id, int slotId);
 
@@ -64,6 +70,8 @@ private:
         StartingDrag,
         Dragging,
         Dropping,
+        Committing,
+        Moving,
         Dropped,
         Canceled,
         Clicked,
@@ -76,14 +84,29 @@ private:
         CantDrop,
     };
 
+    struct Latency {
+        quint32 count;
+        qint64 total;
+        qint64 longest;
+
+        void record(qint64 msecs);
+        QVariantMap toMap() const;
+    };
+
     bool mayBeAClick(QMouseEvent *event);
+    bool tapToMove();
+    void place(Slot *slot);
+    void rollBack();
     void checkTargets(bool force = false);
     void highlightOrDrop();
+    void highlight(Slot *slot);
     static bool couldBeDoubleClick(const Card *card);
 
     static quint32 s_count;
     static QElapsedTimer s_doubleClickTimer;
     static const Card *s_lastCard;
+    static Latency s_accepted;
+    static Latency s_rolledBack;
 
     DragState m_state;
     quint32 m_id;
@@ -95,7 +118,10 @@ private:
     Card *m_card;
     Slot *m_source;
     int m_target;
+    Slot *m_placedTarget;
+    QElapsedTimer m_commitTimer;
     QList<Slot *> m_targets;
+    QList<Slot *> m_highlights;
     QList<Card *> m_cards;
     QHash<int, Droppability> m_couldDrop;
 };
@@ -15,16 +15,33 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstring>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include "callstats.h"
 #include "constants.h"
+#include "dealrater.h"
 #include "engine.h"
 #include "engine_p.h"
+#include "engineclone.h"
 #include "gameoptionmodel.h"
 #include "interface.h"
+#include "legalmoves.h"
 #include "logging.h"
+#include "positionanalyzer.h"
+#include "solvercache.h"
+#include "watchdog.h"
 
 #define MAX_RETRIES 10
 
+namespace {
+
+const int HintDeadline = 1000;
+
+} // namespace
+
 const QString Constants::GameDirectory = QStringLiteral(QUOTE(DATADIR) "/games");
 const QString StateConf = QStringLiteral("/state");
 
@@ -59,7 +76,36 @@ EnginePrivate::EnginePrivate(QObject *parent)
     , m_timeout(0)
     , m_seed(std::mt19937::default_seed)
     , m_recordingMove(false)
-{
+    , m_detached(false)
+    , m_pendingCall(SCM_BOOL_F)
+    , m_seedDatabase(nullptr)
+    , m_dealFilter(SeedDatabase::AnyDeal)
+    , m_seedDatabaseAvailable(false)
+    , m_solverPool(new QThreadPool(this))
+    , m_analysisGeneration(0)
+    , m_analysisDone(false)
+    , m_positionLost(false)
+    , m_hintTimer(new QTimer(this))
+    , m_hintRequest(0)
+    , m_hintPending(false)
+    , m_legalMoves(new LegalMoves(this))
+    , m_canAutoComplete(false)
+    , m_watchdog(new Watchdog(this))
+    , m_timedOut(false)
+    , m_callStats(nullptr)
+{
+    // Every search uses all but one core, run one of them at a time
+    m_solverPool->setMaxThreadCount(1);
+    m_hintTimer->setSingleShot(true);
+    m_hintTimer->setInterval(HintDeadline);
+    connect(m_hintTimer, &QTimer::timeout, this, [this] {
+        // Analysis keeps going for lost position detection
+        if (m_hintPending) {
+            qCDebug(lcEngine) << "Hint search missed its deadline";
+            m_hintPending = false;
+            scheduleHint(m_hintRequest);
+        }
+    });
 }
 
 EnginePrivate::~EnginePrivate()
@@ -68,6 +114,12 @@ EnginePrivate::~EnginePrivate()
         m_delayedCallTimer->stop();
         delete m_delayedCallTimer;
     }
+    cancelRating();
+    cancelAnalysis();
+    delete m_seedDatabase;
+    delete m_legalMoves;
+    delete m_callStats;
+    clearProcedures();
 }
 
 EnginePrivate *EnginePrivate::instance()
@@ -97,6 +149,8 @@ Engine::Engine(QObject *parent)
 {
     qRegisterMetaType<CardData>();
     qRegisterMetaType<CardList>();
+    qRegisterMetaType<MoveData>();
+    qRegisterMetaType<MoveList>();
     qRegisterMetaType<ActionType>();
     qRegisterMetaType<GameOption>();
     qRegisterMetaType<GameOptionList>();
@@ -134,6 +188,8 @@ void Engine::loadGame(const QString &gameFile, bool restored)
 {
     qCDebug(lcEngine) << "Loading game from" << gameFile;
     d_ptr->clear(true);
+    // The new game may define procedures with the same names
+    d_ptr->clearProcedures();
     bool error = false;
     scm_c_catch(SCM_BOOL_T, Scheme::loadGameFromFile, (void *)&gameFile,
                 Scheme::catchHandler, &error, Scheme::preUnwindHandler, &error);
@@ -144,6 +200,7 @@ void Engine::loadGame(const QString &gameFile, bool restored)
         qCDebug(lcEngine) << "Loaded" << gameFile;
         d_ptr->m_state = restored ? EnginePrivate::RestoredState : EnginePrivate::LoadedState;
         d_ptr->m_gameFile = gameFile;
+        d_ptr->loadSeedDatabase(gameFile);
 #ifndef ENGINE_EXERCISER
         GameOptionList options = d_ptr->getGameOptions();
         if (!options.isEmpty() && GameOptionModel::loadOptions(gameFile, options) && !setGameOptions(options)) {
@@ -192,6 +249,13 @@ void Engine::startEngine(bool newSeed)
 
     d_ptr->m_state = EnginePrivate::RunningState;
     emit gameStarted();
+    d_ptr->updateAutoComplete();
+    d_ptr->updateSeedDatabaseAvailable();
+    d_ptr->cancelAnalysis();
+    d_ptr->setPositionLost(false);
+#ifndef ENGINE_EXERCISER
+    d_ptr->rateDeal();
+#endif // ENGINE_EXERCISER
 
     d_ptr->testGameOver();
 }
@@ -218,6 +282,8 @@ void Engine::undoMove()
 
     emit moveEnded();
     d_ptr->updateDealable();
+    d_ptr->updateAutoComplete();
+    d_ptr->analyzePosition(false);
 }
 
 void Engine::redoMove()
@@ -227,50 +293,49 @@ void Engine::redoMove()
     } else {
         emit moveEnded();
         d_ptr->updateDealable();
+        d_ptr->updateAutoComplete();
         d_ptr->testGameOver();
+        d_ptr->analyzePosition(false);
     }
 }
 
 void Engine::dealCard()
 {
-    d_ptr->recordMove(-1);
-    if (!d_ptr->makeSCMCall(QStringLiteral("do-deal-next-cards"), nullptr, 0, nullptr))
+    EnginePrivate::Snapshot snapshot;
+    if (!d_ptr->takeRecoverySnapshot(&snapshot)) {
         d_ptr->die("Can not deal card");
-    else
+        return;
+    }
+
+    d_ptr->recordMove(-1);
+    if (d_ptr->makeSCMCall(QStringLiteral("do-deal-next-cards"), nullptr, 0, nullptr)) {
         d_ptr->endMove();
+    } else if (d_ptr->timedOut()) {
+        d_ptr->recover(snapshot);
+        d_ptr->discardMove();
+    } else {
+        d_ptr->die("Can not deal card");
+    }
+    d_ptr->releaseSnapshot(&snapshot);
 }
 
-void Engine::getHint()
+void Engine::getHint(quint32 id)
 {
-    SCM data;
-    QString message = QStringLiteral("Hints are not supported");
-    if (!d_ptr->makeSCMCall(EnginePrivate::HintLambda, nullptr, 0, &data)) {
-        d_ptr->die("Can not get hint");
+    d_ptr->requestHint(id);
+}
+
+void Engine::computeHint(quint32 id, quint32 generation)
+{
+    // Position changed after the request
+    if (generation != d_ptr->m_analysisGeneration)
         return;
-    }
 
-    scm_dynwind_begin((scm_t_dynwind_flags)0);
-    if (!scm_is_false(data)) {
-        int type = scm_to_int(SCM_CAR(data));
-        if (type == 0) {
-            SCM string = SCM_CADR(data);
-            auto msg = Scheme::getUtf8String(string);
-            if (!msg.isEmpty()) {
-                message = msg;
-                if (message.endsWith(QChar('.')))
-                    message.truncate(message.length()-1);
-            }
-        } else if (type == 1 || type == 2) {
-            SCM string1 = SCM_CADR(data);
-            SCM string2 = SCM_CADDR(data);
-            auto msg1 = Scheme::getUtf8String(string1);
-            auto msg2 = Scheme::getUtf8String(string2);
-            if (!msg1.isEmpty() && !msg2.isEmpty())
-                message = QStringLiteral("Move %1 onto %2").arg(msg1).arg(msg2);
-        }
+    QString message;
+    if (!d_ptr->getSchemeHint(&message) && !d_ptr->timedOut()) {
+        d_ptr->die("Can not get hint");
+        return;
     }
-    scm_dynwind_end();
-    emit hint(message);
+    emit hint(id, message);
 }
 
 bool Engine::drag(quint32 id, int slotId, const CardList &cards)
@@ -288,8 +353,11 @@ bool Engine::drag(quint32 id, int slotId, const CardList &cards)
 
     SCM rv;
     if (!d_ptr->makeSCMCall(EnginePrivate::ButtonPressedLambda, args, 2, &rv)) {
-        d_ptr->die("Can not start drag");
-        return false;
+        if (!d_ptr->timedOut()) {
+            d_ptr->die("Can not start drag");
+            return false;
+        }
+        rv = SCM_BOOL_F;
     }
 
     scm_remember_upto_here_2(args[0], args[1]);
@@ -298,9 +366,12 @@ bool Engine::drag(quint32 id, int slotId, const CardList &cards)
         // Remove cards from the slot, assumes that they are removed from the end
         for (int i = cards.count(); i > 0; i--)
             d_ptr->m_cardSlots[slotId].removeLast();
+        d_ptr->m_legalMoves->invalidate(slotId);
     }
 
     emit couldDrag(id, slotId, scm_is_true(rv));
+    if (!scm_is_true(rv))
+        d_ptr->discardMove();
     return scm_is_true(rv);
 }
 
@@ -309,6 +380,7 @@ void Engine::cancelDrag(quint32 id, int slotId, const CardList &cards)
     Q_UNUSED(id) // There is no signal to send back
     qCDebug(lcEngine) << "Canceling move, putting back" << cards.count() << "cards to slot" << slotId;
     d_ptr->m_cardSlots[slotId].append(cards); // Put the cards back
+    d_ptr->m_legalMoves->invalidate(slotId);
     d_ptr->discardMove();
 }
 
@@ -326,8 +398,11 @@ bool Engine::checkDrop(quint32 id, int startSlotId, int endSlotId, const CardLis
 
     SCM rv;
     if (!d_ptr->makeSCMCall(EnginePrivate::DroppableLambda, args, 3, &rv)) {
-        d_ptr->die("Can not check if dropping is allowed");
-        return false;
+        if (!d_ptr->timedOut()) {
+            d_ptr->die("Can not check if dropping is allowed");
+            return false;
+        }
+        rv = SCM_BOOL_F;
     }
 
     scm_remember_upto_here(args[0], args[1], args[2]);
@@ -344,6 +419,12 @@ bool Engine::drop(quint32 id, int startSlotId, int endSlotId, const CardList &ca
         return false;
     }
 
+    EnginePrivate::Snapshot snapshot;
+    if (!d_ptr->takeRecoverySnapshot(&snapshot)) {
+        d_ptr->die("Can not drop");
+        return false;
+    }
+
     SCM args[3];
     args[0] = scm_from_int(startSlotId);
     args[1] = Scheme::slotToSCM(cards);
@@ -351,9 +432,15 @@ bool Engine::drop(quint32 id, int startSlotId, int endSlotId, const CardList &ca
 
     SCM rv;
     if (!d_ptr->makeSCMCall(EnginePrivate::ButtonReleasedLambda, args, 3, &rv)) {
-        d_ptr->die("Can not drop");
-        return false;
+        if (!d_ptr->timedOut()) {
+            d_ptr->releaseSnapshot(&snapshot);
+            d_ptr->die("Can not drop");
+            return false;
+        }
+        d_ptr->recover(snapshot);
+        rv = SCM_BOOL_F;
     }
+    d_ptr->releaseSnapshot(&snapshot);
 
     scm_remember_upto_here(args[0], args[1], args[2]);
 
@@ -366,8 +453,51 @@ bool Engine::drop(quint32 id, int startSlotId, int endSlotId, const CardList &ca
     return scm_is_true(rv);
 }
 
+bool Engine::move(quint32 id, int startSlotId, int endSlotId, const CardList &cards)
+{
+    // Drag and drop in one go, cards are put back if either fails
+    if (cards.isEmpty()) {
+        emit dropped(id, endSlotId, false);
+        return false;
+    }
+
+    EnginePrivate::Snapshot snapshot;
+    if (!d_ptr->takeRecoverySnapshot(&snapshot)) {
+        d_ptr->die("Can not move");
+        return false;
+    }
+
+    d_ptr->recordMove(startSlotId);
+
+    bool could;
+    if (!d_ptr->moveCards(startSlotId, endSlotId, cards, &could)) {
+        if (!d_ptr->timedOut()) {
+            d_ptr->releaseSnapshot(&snapshot);
+            d_ptr->die("Can not move");
+            return false;
+        }
+        d_ptr->recover(snapshot);
+        could = false;
+    }
+    d_ptr->releaseSnapshot(&snapshot);
+
+    emit dropped(id, endSlotId, could);
+
+    if (could)
+        d_ptr->endMove();
+    else
+        d_ptr->discardMove();
+    return could;
+}
+
 bool Engine::click(quint32 id, int slotId)
 {
+    EnginePrivate::Snapshot snapshot;
+    if (!d_ptr->takeRecoverySnapshot(&snapshot)) {
+        d_ptr->die("Can not click");
+        return false;
+    }
+
     d_ptr->recordMove(-1);
 
     SCM args[1];
@@ -375,9 +505,15 @@ bool Engine::click(quint32 id, int slotId)
 
     SCM rv;
     if (!d_ptr->makeSCMCall(EnginePrivate::ButtonClickedLambda, args, 1, &rv)) {
-        d_ptr->die("Can not click");
-        return false;
+        if (!d_ptr->timedOut()) {
+            d_ptr->releaseSnapshot(&snapshot);
+            d_ptr->die("Can not click");
+            return false;
+        }
+        d_ptr->recover(snapshot);
+        rv = SCM_BOOL_F;
     }
+    d_ptr->releaseSnapshot(&snapshot);
 
     scm_remember_upto_here_1(args[0]);
 
@@ -392,6 +528,12 @@ bool Engine::click(quint32 id, int slotId)
 
 bool Engine::doubleClick(quint32 id, int slotId)
 {
+    EnginePrivate::Snapshot snapshot;
+    if (!d_ptr->takeRecoverySnapshot(&snapshot)) {
+        d_ptr->die("Can not double click");
+        return false;
+    }
+
     d_ptr->recordMove(-1);
 
     SCM args[1];
@@ -399,9 +541,15 @@ bool Engine::doubleClick(quint32 id, int slotId)
 
     SCM rv;
     if (!d_ptr->makeSCMCall(EnginePrivate::ButtonDoubleClickedLambda, args, 1, &rv)) {
-        d_ptr->die("Can not double click");
-        return false;
+        if (!d_ptr->timedOut()) {
+            d_ptr->releaseSnapshot(&snapshot);
+            d_ptr->die("Can not double click");
+            return false;
+        }
+        d_ptr->recover(snapshot);
+        rv = SCM_BOOL_F;
     }
+    d_ptr->releaseSnapshot(&snapshot);
 
     scm_remember_upto_here_1(args[0]);
 
@@ -414,6 +562,111 @@ bool Engine::doubleClick(quint32 id, int slotId)
     return scm_is_true(rv);
 }
 
+void Engine::autoPlay(bool all)
+{
+    if (d_ptr->m_state != EnginePrivate::RunningState || d_ptr->m_recordingMove
+            || d_ptr->m_delayedCallTimer) {
+        qCDebug(lcEngine) << "Engine is busy, can not play cards to foundations";
+        emit autoPlayed(0);
+        return;
+    }
+
+    EnginePrivate::Snapshot snapshot;
+    if (!d_ptr->takeRecoverySnapshot(&snapshot)) {
+        d_ptr->die("Can not play cards to foundations");
+        return;
+    }
+
+    // All cards go to one undo step and the table is updated once at the end
+    d_ptr->recordMove(-1);
+    int count;
+    if (!d_ptr->playToFoundations(all, &count)) {
+        if (!d_ptr->timedOut()) {
+            d_ptr->releaseSnapshot(&snapshot);
+            d_ptr->die("Can not play cards to foundations");
+            return;
+        }
+        d_ptr->recover(snapshot);
+        count = 0;
+    }
+    d_ptr->releaseSnapshot(&snapshot);
+
+    qCDebug(lcEngine) << "Played" << count << "cards to foundations";
+    emit autoPlayed(count);
+
+    if (count > 0)
+        d_ptr->endMove();
+    else
+        d_ptr->discardMove();
+}
+
+void Engine::requestMoves(quint32 id)
+{
+    MoveList moves;
+    if (d_ptr->m_state == EnginePrivate::RunningState && !d_ptr->m_legalMoves->moves(&moves)) {
+        d_ptr->m_legalMoves->invalidateAll();
+        if (!d_ptr->timedOut()) {
+            d_ptr->die("Can not list legal moves");
+            return;
+        }
+        moves.clear();
+    }
+    emit legalMoves(id, moves);
+}
+
+void Engine::setCallBudget(int msecs)
+{
+    d_ptr->setCallBudget(msecs);
+}
+
+void Engine::setCallStatsEnabled(bool enabled)
+{
+    d_ptr->setCallStatsEnabled(enabled);
+}
+
+void Engine::requestCallStats(quint32 id)
+{
+    emit callStats(id, d_ptr->getCallStats());
+}
+
+void Engine::setDealFilter(int filter)
+{
+    qCDebug(lcEngine) << "Setting deal filter to" << filter;
+    d_ptr->m_dealFilter = static_cast<SeedDatabase::Filter>(filter);
+}
+
+void Engine::handleDealRated(quint32 seed, int rating)
+{
+    // Ratings of earlier deals may still arrive
+    if (seed == d_ptr->m_seed && d_ptr->m_state >= EnginePrivate::RunningState) {
+        qCDebug(lcEngine) << "Deal rated as" << rating;
+        d_ptr->m_ratingSolver.reset();
+        emit dealRated(rating);
+    }
+}
+
+void Engine::handlePositionAnalyzed(quint32 generation, bool lost, int from, int to, int count)
+{
+    // Analysis of an earlier position may still arrive
+    if (generation == d_ptr->m_analysisGeneration && d_ptr->m_state == EnginePrivate::RunningState) {
+        d_ptr->m_analysisSolver.reset();
+        d_ptr->m_analysisDone = true;
+        QString hint;
+        if (from >= 0)
+            hint = d_ptr->getSolverHint(from, to, count);
+        d_ptr->m_hint = hint;
+        d_ptr->setPositionLost(lost);
+        if (d_ptr->m_hintPending) {
+            d_ptr->m_hintPending = false;
+            d_ptr->m_hintTimer->stop();
+            if (hint.isEmpty())
+                d_ptr->scheduleHint(d_ptr->m_hintRequest);
+            else
+                emit this->hint(d_ptr->m_hintRequest, hint);
+        }
+    }
+}
+
 void Engine::requestGameOptions()
 {
     emit gameOptions(d_ptr->getGameOptions());
@@ -589,6 +842,157 @@ void EnginePrivate::updateDealable()
     }
 }
 
+bool EnginePrivate::canFinish()
+{
+    // Dry run of the button on a clone, it must move every card home
+    EngineClone clone(this);
+    int count;
+    if (!clone.isValid() || !clone.playToFoundations(true, &count))
+        return false;
+
+    for (auto it = clone.slots().constBegin(); it != clone.slots().constEnd(); ++it) {
+        if (m_slotTypes.value(it.key()) != FoundationSlot && !it.value().isEmpty())
+            return false;
+    }
+    return true;
+}
+
+void EnginePrivate::updateAutoComplete()
+{
+    // When all cards are visible and there is nothing left to deal,
+    // only moving the cards to foundations remains in most games
+    bool canAutoComplete = m_state == RunningState && m_slotTypes.values().contains(FoundationSlot);
+    bool cardsLeft = false;
+    for (auto it = m_cardSlots.constBegin(); canAutoComplete && it != m_cardSlots.constEnd(); ++it) {
+        SlotType type = m_slotTypes.value(it.key());
+        if (type == FoundationSlot || it.value().isEmpty())
+            continue;
+        cardsLeft = true;
+        if (type == StockSlot) {
+            canAutoComplete = false;
+        } else {
+            for (const CardData &card : it.value()) {
+                if (!card.show) {
+                    canAutoComplete = false;
+                    break;
+                }
+            }
+        }
+    }
+    canAutoComplete = canAutoComplete && cardsLeft;
+
+    // That is not the case in open games like FreeCell from the first move,
+    // nor when foundations take whole suits like in Spider
+    if (canAutoComplete)
+        canAutoComplete = canFinish();
+
+    if (m_canAutoComplete != canAutoComplete) {
+        m_canAutoComplete = canAutoComplete;
+        qCDebug(lcEngine) << (canAutoComplete ? "Can" : "Can't") << "auto complete";
+        emit engine()->canAutoComplete(canAutoComplete);
+    }
+}
+
+bool EnginePrivate::moveCards(int startSlotId, int endSlotId, const CardList &cards, bool *moved)
+{
+    SCM args[3];
+    args[0] = scm_from_int(startSlotId);
+    args[1] = Scheme::slotToSCM(cards);
+    args[2] = scm_from_int(endSlotId);
+
+    SCM rv;
+    if (!makeSCMCall(ButtonPressedLambda, args, 2, &rv))
+        return false;
+
+    *moved = scm_is_true(rv);
+    if (*moved) {
+        CardList &slot = m_cardSlots[startSlotId];
+        slot.erase(slot.end() - cards.count(), slot.end());
+        m_legalMoves->invalidate(startSlotId);
+
+        if (!makeSCMCall(ButtonReleasedLambda, args, 3, &rv))
+            return false;
+
+        *moved = scm_is_true(rv);
+        if (!*moved)
+            m_cardSlots[startSlotId].append(cards);
+    }
+
+    scm_remember_upto_here(args[0], args[1], args[2]);
+    return true;
+}
+
+bool EnginePrivate::playToFoundations(bool all, int *count)
+{
+    QList<int> foundations;
+    QList<int> others;
+    for (auto it = m_slotTypes.constBegin(); it != m_slotTypes.constEnd(); ++it)
+        (it.value() == FoundationSlot ? foundations : others).append(it.key());
+    std::sort(foundations.begin(), foundations.end());
+    std::sort(others.begin(), others.end());
+
+    // Delayed calls are run right after each move instead of waiting for a
+    // timer, a clone may have detached the engine already
+    bool wasDetached = isDetached();
+    setDetached(true);
+
+    *count = 0;
+    bool moved = true;
+    while (moved) {
+        moved = false;
+
+        // A card is safe to move when the cards that may still need it to
+        // build on are already in foundations
+        int lowest = RankAceHigh;
+        for (int id : others) {
+            for (const CardData &card : m_cardSlots[id])
+                lowest = qMin(lowest, card.rank == RankAceHigh ? int(RankAce) : int(card.rank));
+        }
+
+        for (int id : others) {
+            const CardList &slot = m_cardSlots[id];
+            if (slot.isEmpty() || !slot.last().show)
+                continue;
+            CardData card = slot.last();
+            int rank = card.rank == RankAceHigh ? int(RankAce) : int(card.rank);
+            if (!all && rank > lowest + 1)
+                continue;
+
+            for (int foundation : foundations) {
+                if (hasFeature(FeatureDroppable)) {
+                    SCM args[3];
+                    args[0] = scm_from_int(id);
+                    args[1] = Scheme::slotToSCM(CardList() << card);
+                    args[2] = scm_from_int(foundation);
+                    SCM rv;
+                    if (!makeSCMCall(DroppableLambda, args, 3, &rv)) {
+                        setDetached(wasDetached);
+                        return false;
+                    }
+                    scm_remember_upto_here(args[0], args[1], args[2]);
+                    if (!scm_is_true(rv))
+                        continue;
+                }
+
+                if (!moveCards(id, foundation, CardList() << card, &moved) || !runPendingCall()) {
+                    setDetached(wasDetached);
+                    return false;
+                }
+                if (moved)
+                    break;
+            }
+
+            if (moved) {
+                (*count)++;
+                break;
+            }
+        }
+    }
+
+    setDetached(wasDetached);
+    return true;
+}
+
 void EnginePrivate::recordMove(int slotId)
 {
     qCDebug(lcEngine) << "Start recording move for slot" << slotId
@@ -623,7 +1027,9 @@ void EnginePrivate::endMove(bool fromDelayedCall)
     }
 
     updateDealable();
+    updateAutoComplete();
     testGameOver();
+    analyzePosition(true);
 }
 
 void EnginePrivate::discardMove()
@@ -669,7 +1075,15 @@ void EnginePrivate::clear(bool resetData)
         setCanRedo(false);
         setCanDeal(false);
     }
+    cancelRating();
+    cancelAnalysis();
+    m_legalMoves->invalidateAll();
+    if (m_canAutoComplete) {
+        m_canAutoComplete = false;
+        emit engine()->canAutoComplete(false);
+    }
     m_cardSlots.clear();
+    m_slotTypes.clear();
     emit engine()->clearData();
 }
 
@@ -730,6 +1144,8 @@ void EnginePrivate::addSlot(int id, const CardList &cards, SlotType type,
                             bool expandedDown, bool expandedRight)
 {
     m_cardSlots.insert(id, cards);
+    m_slotTypes.insert(id, type);
+    m_legalMoves->invalidateAll();
     emit engine()->newSlot(id, cards, type, x, y, expansionDepth, expandedDown, expandedRight);
 }
 
@@ -740,6 +1156,9 @@ const CardList &EnginePrivate::getSlot(int slot)
 
 void EnginePrivate::setCards(int id, const CardList &cards)
 {
+    if (m_cardSlots.value(id) != cards)
+        m_legalMoves->invalidate(id);
+
     if (cards.isEmpty()) {
         if (!m_cardSlots[id].isEmpty()) {
             qCDebug(lcEngine) << "Clearing slot" << id;
@@ -835,30 +1254,414 @@ quint32 EnginePrivate::getRandomValue(quint32 first, quint32 last) {
 void EnginePrivate::resetGenerator(bool generateNewSeed)
 {
     static std::random_device seedGenerator;
-    if (generateNewSeed)
+    if (generateNewSeed) {
         m_seed = seedGenerator();
+        if (m_dealFilter != SeedDatabase::AnyDeal && m_seedDatabase
+                && m_seedDatabase->options() == SeedDatabase::optionsMask(getGameOptions())) {
+            quint32 seed;
+            if (m_seedDatabase->pick(m_dealFilter, seedGenerator(), &seed))
+                m_seed = seed;
+            else
+                qCDebug(lcEngine) << "No matching deals in seed database";
+        }
+    }
     m_generator = std::mt19937(m_seed);
 }
 
+void EnginePrivate::rateDeal()
+{
+    cancelRating();
+
+    quint32 seed = m_seed;
+    GameOptionList options = getGameOptions();
+    if (m_seedDatabase && m_seedDatabase->options() == SeedDatabase::optionsMask(options)
+            && m_seedDatabase->classification(seed) != SeedDatabase::Unknown) {
+        emit engine()->dealRated(m_seedDatabase->rating(seed));
+        return;
+    }
+
+    // Searching with Scheme would block the engine, only native solvers
+    // can rate in the background
+    SolverPosition position;
+    Solver *solver = Solver::create(m_gameFile, options);
+    if (!solver || !SolverPosition::fromSlots(m_cardSlots, m_slotTypes, &position)) {
+        delete solver;
+        emit engine()->dealRated(SeedDatabase::UnknownRating);
+        return;
+    }
+
+    quint64 gameKey = SolverCache::gameKey(m_gameFile, options);
+    SolverCache::Record record;
+    if (SolverCache::instance()->lookup(gameKey, SolverCache::positionKey(position), &record)) {
+        delete solver;
+        emit engine()->dealRated(record.outcome == Solver::Solvable
+                                 ? SeedDatabase::rate(SeedDatabase::Solvable, record.difficulty)
+                                 : SeedDatabase::UnwinnableRating);
+        return;
+    }
+
+    // The solver is used only for this deal, canceling it is permanent
+    emit engine()->dealRated(SeedDatabase::UnknownRating);
+    m_ratingSolver.reset(solver);
+    m_solverPool->start(new DealRater(m_ratingSolver, position, gameKey, seed));
+}
+
+void EnginePrivate::cancelRating()
+{
+    if (m_ratingSolver) {
+        m_ratingSolver->cancel();
+        m_ratingSolver.reset();
+    }
+}
+
+void EnginePrivate::analyzePosition(bool forward)
+{
+    cancelAnalysis();
+
+    // Undoing may bring back a winnable position, moving forward can not
+    if (!forward)
+        setPositionLost(false);
+    else if (m_positionLost)
+        return;
+
+#ifndef ENGINE_EXERCISER
+    if (m_state != RunningState || m_detached)
+        return;
+
+    SolverPosition position;
+    GameOptionList options = getGameOptions();
+    Solver *solver = Solver::create(m_gameFile, options);
+    if (!solver || !SolverPosition::fromSlots(m_cardSlots, m_slotTypes, &position)) {
+        delete solver;
+        return;
+    }
+
+    // The solver would see the cards facing down, leave hints to Scheme
+    // until all of them have been shown. Sampling them with estimate is
+    // not done as a few dead samples do not prove the game lost.
+    if (position.hasHiddenCards()) {
+        delete solver;
+        m_analysisDone = true;
+        return;
+    }
+
+    // Positions are often seen again after undo or restart
+    quint64 gameKey = SolverCache::gameKey(m_gameFile, options);
+    SolverCache::Record record;
+    if (SolverCache::instance()->lookup(gameKey, SolverCache::positionKey(position), &record)) {
+        delete solver;
+        m_analysisDone = true;
+        if (record.outcome == Solver::Solvable && record.hasMove) {
+            const SolverMove &move = record.move;
+            m_hint = getSolverHint(position.slotIds[move.from], position.slotIds[move.to],
+                                   move.kind == SolverMove::Transfer ? move.count : 0);
+        }
+        setPositionLost(record.outcome == Solver::Unsolvable);
+        return;
+    }
+
+    m_analysisSolver.reset(solver);
+    m_solverPool->start(new PositionAnalyzer(m_analysisSolver, position, gameKey,
+                                             m_analysisGeneration));
+#endif // ENGINE_EXERCISER
+}
+
+void EnginePrivate::cancelAnalysis()
+{
+    // Hints requested for the old position are dropped too
+    m_analysisGeneration++;
+    m_analysisDone = false;
+    m_hint.clear();
+    m_hintPending = false;
+    m_hintTimer->stop();
+    if (m_analysisSolver) {
+        m_analysisSolver->cancel();
+        m_analysisSolver.reset();
+    }
+}
+
+void EnginePrivate::setPositionLost(bool lost)
+{
+    if (m_positionLost != lost) {
+        qCDebug(lcEngine) << "Position" << (lost ? "is" : "is not") << "lost";
+        m_positionLost = lost;
+        emit engine()->positionLost(lost);
+    }
+}
+
+void EnginePrivate::requestHint(quint32 id)
+{
+    // Moves usually start the search already, otherwise start it now
+    if (!m_analysisSolver && !m_analysisDone)
+        analyzePosition(true);
+
+    if (!m_hint.isEmpty()) {
+        emit engine()->hint(id, m_hint);
+    } else if (m_analysisSolver) {
+        m_hintRequest = id;
+        m_hintPending = true;
+        m_hintTimer->start();
+    } else {
+        scheduleHint(id);
+    }
+}
+
+void EnginePrivate::scheduleHint(quint32 id)
+{
+    // Let queued drags and drops go first
+    QMetaObject::invokeMethod(engine(), "computeHint", Qt::QueuedConnection,
+                              Q_ARG(quint32, id), Q_ARG(quint32, m_analysisGeneration));
+}
+
+bool EnginePrivate::getSchemeHint(QString *message)
+{
+    SCM data;
+    //% "Hints are not supported"
+    *message = qtTrId("patience-la-hints_not_supported");
+    if (!makeSCMCall(HintLambda, nullptr, 0, &data))
+        return false;
+
+    scm_dynwind_begin((scm_t_dynwind_flags)0);
+    if (!scm_is_false(data)) {
+        int type = scm_to_int(SCM_CAR(data));
+        if (type == 0) {
+            SCM string = SCM_CADR(data);
+            auto msg = Scheme::getUtf8String(string);
+            if (!msg.isEmpty()) {
+                *message = msg;
+                if (message->endsWith(QChar('.')))
+                    message->truncate(message->length()-1);
+            }
+        } else if (type == 1 || type == 2) {
+            SCM string1 = SCM_CADR(data);
+            SCM string2 = SCM_CADDR(data);
+            auto msg1 = Scheme::getUtf8String(string1);
+            auto msg2 = Scheme::getUtf8String(string2);
+            if (!msg1.isEmpty() && !msg2.isEmpty())
+                //% "Move %1 onto %2"
+                *message = qtTrId("patience-la-hint_move").arg(msg1).arg(msg2);
+        }
+    }
+    scm_dynwind_end();
+    return true;
+}
+
+QString EnginePrivate::getSolverHint(int from, int to, int count)
+{
+    if (count == 0) {
+        //% "Deal a new card from the deck"
+        return qtTrId("patience-la-hint_deal");
+    }
+
+    const CardList &source = m_cardSlots[from];
+    const CardList &target = m_cardSlots[to];
+    if (source.count() < count)
+        return QString();
+
+    // Same words as in the hints of the game
+    QString card = getCardName(source[source.count() - count]);
+    QString onto;
+    if (!target.isEmpty()) {
+        onto = getCardName(target.last());
+    } else if (m_slotTypes.value(to) == FoundationSlot) {
+        //% "an empty foundation"
+        onto = qtTrId("patience-la-hint_empty_foundation");
+    } else if (m_slotTypes.value(to) == TableauSlot) {
+        //% "an empty tableau"
+        onto = qtTrId("patience-la-hint_empty_tableau");
+    } else {
+        //% "an empty slot"
+        onto = qtTrId("patience-la-hint_empty_slot");
+    }
+    if (card.isEmpty() || onto.isEmpty())
+        return QString();
+    return qtTrId("patience-la-hint_move").arg(card).arg(onto);
+}
+
+QString EnginePrivate::getCardName(const CardData &card)
+{
+    SCM args[1];
+    SCM name;
+    args[0] = Scheme::cardToSCM(card);
+    if (!makeSCMCall(QStringLiteral("get-name"), args, 1, &name))
+        return QString();
+
+    scm_dynwind_begin((scm_t_dynwind_flags)0);
+    QString result = Scheme::getUtf8String(name);
+    scm_dynwind_end();
+    return result;
+}
+
+void EnginePrivate::loadSeedDatabase(const QString &gameFile)
+{
+    delete m_seedDatabase;
+    m_seedDatabase = new SeedDatabase(SeedDatabase::path(gameFile));
+    if (!m_seedDatabase->isValid()) {
+        delete m_seedDatabase;
+        m_seedDatabase = nullptr;
+    }
+}
+
+void EnginePrivate::updateSeedDatabaseAvailable()
+{
+    // Options take effect on new games, so this is checked when one starts
+    bool available = m_seedDatabase
+        && m_seedDatabase->options() == SeedDatabase::optionsMask(getGameOptions());
+    if (m_seedDatabaseAvailable != available) {
+        m_seedDatabaseAvailable = available;
+        emit engine()->seedDatabaseAvailable(available);
+    }
+}
+
 void EnginePrivate::die(const char *message)
 {
     emit engine()->engineFailure(QString(message));
 }
 
+bool EnginePrivate::takeRecoverySnapshot(Snapshot *snapshot)
+{
+    // Without the watchdog calls are never interrupted and there is
+    // nothing to recover, avoid the extra Scheme calls then
+    if (m_watchdog->budget() == 0) {
+        snapshot->variables = SCM_BOOL_F;
+        snapshot->score = SCM_BOOL_F;
+        snapshot->taken = false;
+        return true;
+    }
+    return takeSnapshot(snapshot);
+}
+
+bool EnginePrivate::takeSnapshot(Snapshot *snapshot)
+{
+    snapshot->taken = false;
+    snapshot->slots = m_cardSlots;
+    if (!makeSCMCall(QStringLiteral("save-variables"), nullptr, 0, &snapshot->variables)
+            || !makeSCMCall(QStringLiteral("get-score"), nullptr, 0, &snapshot->score))
+        return false;
+    scm_gc_protect_object(snapshot->variables);
+    scm_gc_protect_object(snapshot->score);
+    snapshot->taken = true;
+    return true;
+}
+
+bool EnginePrivate::restoreSnapshot(const Snapshot &snapshot)
+{
+    // Slot contents are read from here by Scheme, no need to tell anyone
+    m_cardSlots = snapshot.slots;
+    m_legalMoves->invalidateAll();
+    SCM variables = snapshot.variables;
+    SCM score = snapshot.score;
+    return makeSCMCall(QStringLiteral("restore-variables"), &variables, 1, nullptr)
+        && makeSCMCall(QStringLiteral("set-score!"), &score, 1, nullptr);
+}
+
+void EnginePrivate::releaseSnapshot(Snapshot *snapshot)
+{
+    if (!snapshot->taken)
+        return;
+    snapshot->taken = false;
+    scm_gc_unprotect_object(snapshot->variables);
+    scm_gc_unprotect_object(snapshot->score);
+    snapshot->variables = SCM_BOOL_F;
+    snapshot->score = SCM_BOOL_F;
+}
+
+void EnginePrivate::setDetached(bool detached)
+{
+    qCDebug(lcEngine) << (detached ? "Detaching" : "Reattaching") << "engine";
+    m_detached = detached;
+    if (!detached && !scm_is_false(m_pendingCall)) {
+        scm_gc_unprotect_object(m_pendingCall);
+        m_pendingCall = SCM_BOOL_F;
+    }
+}
+
+bool EnginePrivate::isDetached() const
+{
+    return m_detached;
+}
+
+void EnginePrivate::setPendingCall(SCM callback)
+{
+    scm_gc_protect_object(callback);
+    if (!scm_is_false(m_pendingCall))
+        scm_gc_unprotect_object(m_pendingCall);
+    m_pendingCall = callback;
+}
+
+bool EnginePrivate::runPendingCall()
+{
+    // Delayed calls are run immediately when the engine is detached
+    while (!scm_is_false(m_pendingCall)) {
+        SCM callback = m_pendingCall;
+        m_pendingCall = SCM_BOOL_F;
+        bool success = makeSCMCall(callback, nullptr, 0, nullptr);
+        scm_gc_unprotect_object(callback);
+        if (!success)
+            return false;
+    }
+    return true;
+}
+
 bool EnginePrivate::makeSCMCall(Lambda lambda, SCM *args, size_t n, SCM *retval)
 {
-    return makeSCMCall(m_lambdas[lambda], args, n, retval);
+    return callSCM(m_lambdas[lambda], args, n, retval, lambdaName(lambda), isInteractive(lambda));
 }
 
 bool EnginePrivate::makeSCMCall(SCM lambda, SCM *args, size_t n, SCM *retval)
+{
+    return callSCM(lambda, args, n, retval, "delayed-call", false);
+}
+
+bool EnginePrivate::makeSCMCall(QString name, SCM *args, size_t n, SCM *retval)
+{
+    // Evaluating the name every time is slow, procedures are kept until
+    // another game is loaded
+    QByteArray utf8 = name.toUtf8();
+    SCM lambda = m_procedures.value(utf8, SCM_BOOL_F);
+    if (scm_is_false(lambda)) {
+        lambda = scm_c_eval_string(utf8.data());
+        scm_gc_protect_object(lambda);
+        m_procedures.insert(utf8, lambda);
+    }
+    return callSCM(lambda, args, n, retval, utf8.constData(), false);
+}
+
+void EnginePrivate::clearProcedures()
+{
+    for (SCM lambda : m_procedures)
+        scm_gc_unprotect_object(lambda);
+    m_procedures.clear();
+}
+
+bool EnginePrivate::callSCM(SCM lambda, SCM *args, size_t n, SCM *retval,
+                            const char *name, bool interactive)
+{
+    if (Q_UNLIKELY(m_callStats)) {
+        QElapsedTimer timer;
+        timer.start();
+        bool success = runSCM(lambda, args, n, retval, name, interactive);
+        m_callStats->record(m_gameFile, name, timer.nsecsElapsed(), success);
+        return success;
+    }
+    return runSCM(lambda, args, n, retval, name, interactive);
+}
+
+bool EnginePrivate::runSCM(SCM lambda, SCM *args, size_t n, SCM *retval,
+                           const char *name, bool interactive)
 {
     Interface::Call call = { lambda, args, n };
     bool error = false;
 
+    m_watchdog->enter(name, interactive);
     SCM r = scm_c_catch(SCM_BOOL_T, Scheme::callLambda, &call,
                         Scheme::catchHandler, &error, Scheme::preUnwindHandler, &error);
+    m_timedOut = m_watchdog->leave() && error;
     if (error) {
-        qCWarning(lcEngine) << "Scheme reported an error";
+        if (m_timedOut)
+            qCWarning(lcEngine) << "Call to" << name << "of" << m_gameFile << "ran out of time";
+        else
+            qCWarning(lcEngine) << "Scheme reported an error";
         return false;
     }
 
@@ -867,13 +1670,66 @@ bool EnginePrivate::makeSCMCall(SCM lambda, SCM *args, size_t n, SCM *retval)
     return true;
 }
 
-bool EnginePrivate::makeSCMCall(QString name, SCM *args, size_t n, SCM *retval)
+bool EnginePrivate::timedOut() const
 {
-    SCM lambda = scm_c_eval_string(name.toUtf8().data());
-    if (!makeSCMCall(lambda, args, n, retval))
+    return m_timedOut;
+}
+
+void EnginePrivate::setCallBudget(int msecs)
+{
+    m_watchdog->setBudget(msecs);
+}
+
+void EnginePrivate::setCallStatsEnabled(bool enabled)
+{
+    if (enabled && !m_callStats) {
+        qCDebug(lcEngine) << "Collecting statistics of Scheme calls";
+        m_callStats = new CallStats;
+    } else if (!enabled && m_callStats) {
+        qCDebug(lcEngine) << "Stopped collecting statistics of Scheme calls";
+        delete m_callStats;
+        m_callStats = nullptr;
+    }
+}
+
+QVariantMap EnginePrivate::getCallStats() const
+{
+    return m_callStats ? m_callStats->toVariant() : QVariantMap();
+}
+
+void EnginePrivate::recover(const Snapshot &snapshot)
+{
+    // Undo what the interrupted call managed to change, table follows the actions
+    for (auto it = snapshot.slots.constBegin(); it != snapshot.slots.constEnd(); ++it)
+        setCards(it.key(), it.value());
+    if (!restoreSnapshot(snapshot))
+        die("Can not recover from interrupted call");
+    else
+        emit engine()->moveEnded();
+}
+
+const char *EnginePrivate::lambdaName(Lambda lambda)
+{
+    const char *name = Interface::LambdaNames;
+    for (int i = 0; i < lambda; ++i)
+        name += strlen(name) + 1;
+    return name;
+}
+
+bool EnginePrivate::isInteractive(Lambda lambda)
+{
+    // User is waiting for these to answer
+    switch (lambda) {
+    case ButtonPressedLambda:
+    case ButtonReleasedLambda:
+    case ButtonClickedLambda:
+    case ButtonDoubleClickedLambda:
+    case DroppableLambda:
+    case DealableLambda:
+        return true;
+    default:
         return false;
-    scm_remember_upto_here_1(lambda);
-    return true;
+    }
 }
 
 Engine *EnginePrivate::engine()
@@ -24,9 +24,11 @@
 
 #include <QObject>
 #include <QString>
+#include <QVariantMap>
 #include "enginedata.h"
 
 class EngineHelper;
+class SeedClassifier;
 class EnginePrivate;
 class Engine : public QObject
 {
@@ -53,13 +55,20 @@ public slots:
     void undoMove();
     void redoMove();
     void dealCard();
-    void getHint();
+    void getHint(quint32 id);
     bool drag(quint32 id, int slotId, const CardList &cards);
     void cancelDrag(quint32 id, int slotId, const CardList &cards);
     bool checkDrop(quint32 id, int startSlotId, int endSlotId, const CardList &cards);
     bool drop(quint32 id, int startSlotId, int endSlotId, const CardList &cards);
+    bool move(quint32 id, int startSlotId, int endSlotId, const CardList &cards);
     bool click(quint32 id, int slotId);
     bool doubleClick(quint32 id, int slotId);
+    void autoPlay(bool all);
+    void requestMoves(quint32 id);
+    void setCallBudget(int msecs);
+    void setCallStatsEnabled(bool enabled);
+    void requestCallStats(quint32 id);
+    void setDealFilter(int filter);
     void requestGameOptions();
     bool setGameOption(const GameOption &option);
     bool setGameOptions(const GameOptionList &options);
@@ -73,9 +82,11 @@ signals:
     void canUndo(bool canUndo);
     void canRedo(bool canRedo);
     void canDeal(bool canDeal);
+    void canAutoComplete(bool canAutoComplete);
+    void seedDatabaseAvailable(bool available);
     void score(int score);
     void message(const QString &message);
-    void hint(const QString &hint);
+    void hint(quint32 id, const QString &hint);
 
     void engineFailure(QString message);
     void gameLoaded(const QString &gameFile);
@@ -102,13 +113,24 @@ signals:
     void dropped(quint32 id, int slotId, bool could);
     void clicked(quint32 id, int slotId, bool could);
     void doubleClicked(quint32 id, int slotId, bool could);
+    void autoPlayed(int count);
 
     void moveEnded();
+    void legalMoves(quint32 id, const MoveList &moves);
+    void callStats(quint32 id, const QVariantMap &stats);
+    void dealRated(int rating);
+    void positionLost(bool lost);
+
+private slots:
+    void handleDealRated(quint32 seed, int rating);
+    void handlePositionAnalyzed(quint32 generation, bool lost, int from, int to, int count);
+    void computeHint(quint32 id, quint32 generation);
 
 private:
     friend EnginePrivate;
 #ifdef ENGINE_EXERCISER
     friend EngineHelper;
+    friend SeedClassifier;
 #endif
 
     void loadGame(const QString &gameFile, bool restored);
@@ -22,12 +22,23 @@
 #include <QHash>
 #include <QList>
 #include <QObject>
+#include <QSharedPointer>
 #include <QTimer>
+#include <QVariantMap>
 #include <random>
 #include "enginedata.h"
+#include "seeddatabase.h"
+#include "solver.h"
 
 class Engine;
 class EngineHelper;
+class SeedClassifier;
+class EngineClone;
+class EngineSolver;
+class CallStats;
+class LegalMoves;
+class QThreadPool;
+class Watchdog;
 class EnginePrivate : public QObject
 {
     Q_OBJECT
@@ -71,12 +82,23 @@ public:
     };
     Q_ENUM(GameState)
 
+    struct Snapshot {
+        QHash<int, CardList> slots;
+        SCM variables;
+        SCM score;
+        bool taken;
+    };
+
     explicit EnginePrivate(QObject *parent = nullptr);
     ~EnginePrivate();
     static EnginePrivate *instance();
 
     GameOptionList getGameOptions();
     void updateDealable();
+    void updateAutoComplete();
+    bool canFinish();
+    bool moveCards(int startSlotId, int endSlotId, const CardList &cards, bool *moved);
+    bool playToFoundations(bool all, int *count);
     void recordMove(int slotId);
     void endMove(bool fromDelayedCall = false);
     void discardMove();
@@ -109,22 +131,54 @@ public:
     void setTimeout(int timeout);
     quint32 getRandomValue(quint32 first, quint32 last);
     void resetGenerator(bool generateNewSeed);
+    void loadSeedDatabase(const QString &gameFile);
+    void updateSeedDatabaseAvailable();
+    void rateDeal();
+    void cancelRating();
+    void analyzePosition(bool forward);
+    void cancelAnalysis();
+    void setPositionLost(bool lost);
+    void requestHint(quint32 id);
+    void scheduleHint(quint32 id);
+    bool getSchemeHint(QString *message);
+    QString getSolverHint(int from, int to, int count);
+    QString getCardName(const CardData &card);
     void die(const char *message);
 
+    bool takeSnapshot(Snapshot *snapshot);
+    bool takeRecoverySnapshot(Snapshot *snapshot);
+    bool restoreSnapshot(const Snapshot &snapshot);
+    void releaseSnapshot(Snapshot *snapshot);
+    void setDetached(bool detached);
+    bool isDetached() const;
+    void setPendingCall(SCM callback);
+    bool runPendingCall();
+
     bool makeSCMCall(Lambda lambda, SCM *args, size_t n, SCM *retval);
     bool makeSCMCall(SCM lambda, SCM *args, size_t n, SCM *retval);
     bool makeSCMCall(QString name, SCM *args, size_t n, SCM *retval);
+    bool timedOut() const;
+    void clearProcedures();
+    void setCallBudget(int msecs);
+    void setCallStatsEnabled(bool enabled);
+    QVariantMap getCallStats() const;
+    void recover(const Snapshot &snapshot);
 
     // TODO: Make private
     QTimer *m_delayedCallTimer;
 
 private:
     friend Engine;
+    friend EngineClone;
+    friend EngineSolver;
+    friend LegalMoves;
 #ifdef ENGINE_EXERCISER
     friend EngineHelper;
+    friend SeedClassifier;
 #endif
 
     QHash<int, CardList> m_cardSlots;
+    QHash<int, SlotType> m_slotTypes;
     SCM m_lambdas[LambdaCount];
     GameFeatures m_features;
     GameState m_state;
@@ -133,8 +187,33 @@ private:
     uint_fast32_t m_seed;
     std::mt19937 m_generator;
     bool m_recordingMove;
+    bool m_detached;
+    SCM m_pendingCall;
+    SeedDatabase *m_seedDatabase;
+    SeedDatabase::Filter m_dealFilter;
+    bool m_seedDatabaseAvailable;
+    QThreadPool *m_solverPool;
+    QSharedPointer<Solver> m_ratingSolver;
+    QSharedPointer<Solver> m_analysisSolver;
+    quint32 m_analysisGeneration;
+    bool m_analysisDone;
+    bool m_positionLost;
+    QString m_hint;
+    QTimer *m_hintTimer;
+    quint32 m_hintRequest;
+    bool m_hintPending;
+    LegalMoves *m_legalMoves;
+    bool m_canAutoComplete;
+    Watchdog *m_watchdog;
+    bool m_timedOut;
+    QHash<QByteArray, SCM> m_procedures;
+    CallStats *m_callStats;
 
     Engine *engine();
+    bool callSCM(SCM lambda, SCM *args, size_t n, SCM *retval, const char *name, bool interactive);
+    bool runSCM(SCM lambda, SCM *args, size_t n, SCM *retval, const char *name, bool interactive);
+    static const char *lambdaName(Lambda lambda);
+    static bool isInteractive(Lambda lambda);
 };
 
 #endif // ENGINE_P_H
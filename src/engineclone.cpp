@@ -0,0 +1,131 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "engine.h"
+#include "engineclone.h"
+#include "logging.h"
+
+EngineClone::EngineClone(EnginePrivate *engine)
+    : m_engine(engine)
+    , m_blocker(engine->engine())
+    , m_wasDetached(engine->isDetached())
+    , m_valid(false)
+    , m_dirty(false)
+{
+    m_original.variables = SCM_BOOL_F;
+    m_original.score = SCM_BOOL_F;
+
+    // Move or delayed call in progress would be lost when restoring
+    if (m_engine->m_recordingMove || m_engine->m_delayedCallTimer) {
+        qCWarning(lcEngine) << "Engine is busy, can not clone it";
+        return;
+    }
+
+    m_engine->setDetached(true);
+    m_valid = m_engine->takeSnapshot(&m_original);
+    if (!m_valid)
+        qCWarning(lcEngine) << "Can not take snapshot for clone";
+}
+
+EngineClone::~EngineClone()
+{
+    if (m_valid) {
+        if (!reset())
+            qCCritical(lcEngine) << "Could not restore game state from clone";
+        m_engine->releaseSnapshot(&m_original);
+    }
+    if (!m_wasDetached)
+        m_engine->setDetached(false);
+}
+
+bool EngineClone::isValid() const
+{
+    return m_valid;
+}
+
+const QHash<int, CardList> &EngineClone::slots() const
+{
+    return m_engine->m_cardSlots;
+}
+
+bool EngineClone::call(EnginePrivate::Lambda lambda, SCM *args, size_t n, SCM *retval)
+{
+    if (!m_valid)
+        return false;
+
+    // Any lambda may change the variables, even those that shouldn't
+    m_dirty = true;
+    return m_engine->makeSCMCall(lambda, args, n, retval) && m_engine->runPendingCall();
+}
+
+bool EngineClone::test(EnginePrivate::Lambda lambda, SCM *args, size_t n, bool *result)
+{
+    SCM rv;
+    if (!call(lambda, args, n, &rv))
+        return false;
+    *result = scm_is_true(rv);
+    return true;
+}
+
+bool EngineClone::move(int startSlotId, int endSlotId, const CardList &cards, bool *moved)
+{
+    if (!m_valid)
+        return false;
+
+    m_dirty = true;
+    return m_engine->moveCards(startSlotId, endSlotId, cards, moved) && m_engine->runPendingCall();
+}
+
+bool EngineClone::click(int slotId, bool *clicked)
+{
+    SCM slot = scm_from_int(slotId);
+    bool ok = test(EnginePrivate::ButtonClickedLambda, &slot, 1, clicked);
+    scm_remember_upto_here_1(slot);
+    return ok;
+}
+
+bool EngineClone::deal()
+{
+    if (!m_valid)
+        return false;
+
+    m_dirty = true;
+    return m_engine->makeSCMCall(QStringLiteral("do-deal-next-cards"), nullptr, 0, nullptr)
+        && m_engine->runPendingCall();
+}
+
+bool EngineClone::playToFoundations(bool all, int *count)
+{
+    if (!m_valid)
+        return false;
+
+    m_dirty = true;
+    return m_engine->playToFoundations(all, count);
+}
+
+bool EngineClone::reset()
+{
+    if (!m_valid)
+        return false;
+
+    if (m_dirty) {
+        if (!m_engine->restoreSnapshot(m_original))
+            return false;
+        m_dirty = false;
+    }
+    return true;
+}
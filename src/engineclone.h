@@ -0,0 +1,65 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENGINECLONE_H
+#define ENGINECLONE_H
+
+#include <libguile.h>
+#include <QHash>
+#include <QSignalBlocker>
+#include "engine_p.h"
+#include "enginedata.h"
+
+class Engine;
+
+/*
+ * Copy of the current game state to look ahead without touching the
+ * game that is shown. Guile has only one state, so the engine is
+ * detached and its signals are blocked while a clone is alive, and the
+ * original state is put back when the clone is destroyed. Taking a
+ * clone costs one copy on write of the slots and one call to
+ * save-variables. Only to be used on engine thread.
+ */
+class EngineClone
+{
+public:
+    explicit EngineClone(EnginePrivate *engine);
+    ~EngineClone();
+
+    bool isValid() const;
+    const QHash<int, CardList> &slots() const;
+
+    bool call(EnginePrivate::Lambda lambda, SCM *args, size_t n, SCM *retval);
+    bool test(EnginePrivate::Lambda lambda, SCM *args, size_t n, bool *result);
+    bool move(int startSlotId, int endSlotId, const CardList &cards, bool *moved);
+    bool click(int slotId, bool *clicked);
+    bool deal();
+    bool playToFoundations(bool all, int *count);
+    bool reset();
+
+private:
+    Q_DISABLE_COPY(EngineClone)
+
+    EnginePrivate *m_engine;
+    QSignalBlocker m_blocker;
+    EnginePrivate::Snapshot m_original;
+    bool m_wasDetached;
+    bool m_valid;
+    bool m_dirty;
+};
+
+#endif // ENGINECLONE_H
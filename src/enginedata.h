@@ -84,6 +84,18 @@ Q_DECLARE_METATYPE(struct CardData)
 
 Q_DECLARE_METATYPE(CardList)
 
+struct MoveData {
+    int from;
+    int index;
+    int to;
+};
+
+typedef QList<MoveData> MoveList;
+
+Q_DECLARE_METATYPE(struct MoveData)
+
+Q_DECLARE_METATYPE(MoveList)
+
 #define NoOptionGroup 0
 
 struct GameOption {
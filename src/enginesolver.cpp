@@ -0,0 +1,278 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "engine.h"
+#include "engine_p.h"
+#include "engineclone.h"
+#include "enginesolver.h"
+#include "interface.h"
+#include "logging.h"
+
+namespace {
+
+const int MaxDepth = 500;
+const quint64 VariableHashSize = 0x7fffffff;
+
+inline quint64 mix(quint64 value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+} // namespace
+
+EngineSolver::Result::Result()
+    : outcome(Solver::Unknown)
+    , nodes(0)
+    , deadEnds(0)
+    , depth(0)
+    , msecs(0)
+{
+}
+
+EngineSolver::EngineSolver(EnginePrivate *engine)
+    : m_engine(engine)
+    , m_canceled(0)
+    , m_nodes(0)
+    , m_deadEnds(0)
+    , m_budgetHit(false)
+{
+}
+
+quint64 EngineSolver::hash(const QHash<int, CardList> &slots)
+{
+    QList<int> ids = slots.keys();
+    std::sort(ids.begin(), ids.end());
+
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (int id : ids) {
+        hash = mix(hash ^ (quint64)id);
+        for (const CardData &card : slots[id]) {
+            hash ^= (card.rank & 0x0f) | (card.suit << 4) | (card.show ? 0x40 : 0);
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return mix(hash);
+}
+
+EngineSolver::Result EngineSolver::solve(const Solver::Limits &limits)
+{
+    Result result;
+    if (m_engine->m_state != EnginePrivate::RunningState) {
+        qCWarning(lcSolver) << "Engine is not running, can not solve";
+        return result;
+    }
+
+    EngineClone clone(m_engine);
+    if (!clone.isValid()) {
+        qCWarning(lcSolver) << "Engine can not be cloned, can not solve";
+        return result;
+    }
+
+    m_limits = limits;
+    m_visited.clear();
+    m_path.clear();
+    m_nodes = 0;
+    m_deadEnds = 0;
+    m_budgetHit = false;
+    m_canceled.store(0);
+    m_timer.start();
+
+    Status status = search(0);
+
+    if (status == Won)
+        result.outcome = Solver::Solvable;
+    else if (status == Dead && !m_budgetHit)
+        result.outcome = Solver::Unsolvable;
+    result.nodes = m_nodes;
+    result.deadEnds = m_deadEnds;
+    result.depth = m_path.count();
+    result.msecs = m_timer.elapsed();
+    result.solution = m_path;
+
+    qCDebug(lcSolver) << "Generic search finished with" << result.outcome << "after"
+                      << result.nodes << "nodes in" << result.msecs << "ms";
+    return result;
+}
+
+void EngineSolver::cancel()
+{
+    m_canceled.store(1);
+}
+
+EngineSolver::Status EngineSolver::search(int depth)
+{
+    if (m_canceled.load())
+        return Aborted;
+
+    m_nodes++;
+    if (m_nodes > m_limits.nodes || (m_limits.msecs > 0 && m_timer.hasExpired(m_limits.msecs))
+            || depth >= MaxDepth) {
+        m_budgetHit = true;
+        return Aborted;
+    }
+
+    if (m_engine->isWinningGame())
+        return Won;
+
+    EnginePrivate::Snapshot snapshot;
+    if (!m_engine->takeSnapshot(&snapshot))
+        return Aborted;
+
+    // Scheme variables are part of the position, e.g. redeals left
+    quint64 key = hash(m_engine->m_cardSlots)
+        ^ mix(scm_to_uint64(scm_hash(snapshot.variables, scm_from_uint64(VariableHashSize))));
+    if (m_visited.contains(key) || m_engine->isGameOver()) {
+        m_engine->releaseSnapshot(&snapshot);
+        m_deadEnds++;
+        return Dead;
+    }
+    m_visited.insert(key);
+
+    QVector<Move> moves;
+    if (!candidates(&moves)) {
+        m_engine->releaseSnapshot(&snapshot);
+        return Aborted;
+    }
+
+    Status status = Dead;
+    bool dirty = false;
+    for (const Move &move : moves) {
+        if (dirty && !m_engine->restoreSnapshot(snapshot)) {
+            status = Aborted;
+            break;
+        }
+        dirty = true;
+        // Errors and timeouts make the result unknown, not the move illegal
+        Applied applied = apply(move);
+        if (applied == Failed) {
+            status = Aborted;
+            break;
+        }
+        if (applied == NotMoved)
+            continue;
+        m_path.append(move);
+        status = search(depth + 1);
+        if (status != Dead)
+            break;
+        m_path.removeLast();
+    }
+
+    // Caller restores its own position before trying the next move
+    m_engine->releaseSnapshot(&snapshot);
+    return status;
+}
+
+bool EngineSolver::candidates(QVector<Move> *moves)
+{
+    bool droppable = m_engine->hasFeature(EnginePrivate::FeatureDroppable);
+    QList<int> ids = m_engine->m_cardSlots.keys();
+    std::sort(ids.begin(), ids.end());
+
+    for (int from : ids) {
+        const CardList cards = m_engine->m_cardSlots[from];
+        for (int index = cards.count() - 1; index >= 0 && cards[index].show; index--) {
+            CardList dragged = cards.mid(index);
+            SCM args[3];
+            args[0] = scm_from_int(from);
+            args[1] = Scheme::slotToSCM(dragged);
+            SCM rv;
+            if (!m_engine->makeSCMCall(EnginePrivate::ButtonPressedLambda, args, 2, &rv))
+                return false;
+            if (!scm_is_true(rv))
+                continue;
+
+            for (int to : ids) {
+                if (to == from)
+                    continue;
+                if (droppable) {
+                    args[2] = scm_from_int(to);
+                    if (!m_engine->makeSCMCall(EnginePrivate::DroppableLambda, args, 3, &rv))
+                        return false;
+                    if (!scm_is_true(rv))
+                        continue;
+                }
+                moves->append({ Move::Drag, from, index, to });
+            }
+            scm_remember_upto_here(args[0], args[1], args[2]);
+        }
+    }
+
+    // Clicking may do anything, try them after dragging
+    for (int slot : ids)
+        moves->append({ Move::Click, slot, -1, -1 });
+
+    if (m_engine->hasFeature(EnginePrivate::FeatureDealable)) {
+        SCM rv;
+        if (!m_engine->makeSCMCall(EnginePrivate::DealableLambda, nullptr, 0, &rv))
+            return false;
+        if (scm_is_true(rv))
+            moves->append({ Move::Deal, -1, -1, -1 });
+    }
+    return true;
+}
+
+EngineSolver::Applied EngineSolver::apply(const Move &move)
+{
+    quint64 before = hash(m_engine->m_cardSlots);
+    SCM rv = SCM_BOOL_F;
+
+    switch (move.kind) {
+    case Move::Drag: {
+        CardList &cards = m_engine->m_cardSlots[move.from];
+        CardList dragged = cards.mid(move.index);
+        SCM args[3];
+        args[0] = scm_from_int(move.from);
+        args[1] = Scheme::slotToSCM(dragged);
+        args[2] = scm_from_int(move.to);
+        if (!m_engine->makeSCMCall(EnginePrivate::ButtonPressedLambda, args, 2, &rv))
+            return Failed;
+        if (!scm_is_true(rv))
+            return NotMoved;
+        cards.erase(cards.begin() + move.index, cards.end());
+        if (!m_engine->makeSCMCall(EnginePrivate::ButtonReleasedLambda, args, 3, &rv))
+            return Failed;
+        scm_remember_upto_here(args[0], args[1], args[2]);
+        break;
+    }
+    case Move::Click: {
+        SCM slot = scm_from_int(move.from);
+        if (!m_engine->makeSCMCall(EnginePrivate::ButtonClickedLambda, &slot, 1, &rv))
+            return Failed;
+        scm_remember_upto_here_1(slot);
+        break;
+    }
+    case Move::Deal:
+        rv = SCM_BOOL_T;
+        if (!m_engine->makeSCMCall(QStringLiteral("do-deal-next-cards"), nullptr, 0, nullptr))
+            return Failed;
+        break;
+    }
+
+    if (!scm_is_true(rv))
+        return NotMoved;
+    if (!m_engine->runPendingCall())
+        return Failed;
+
+    // Moves that change nothing only make the search longer
+    return hash(m_engine->m_cardSlots) != before ? Moved : NotMoved;
+}
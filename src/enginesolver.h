@@ -0,0 +1,97 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENGINESOLVER_H
+#define ENGINESOLVER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QVector>
+#include "enginedata.h"
+#include "solver.h"
+
+class EnginePrivate;
+
+/*
+ * Game agnostic solver that asks the game's lambdas which moves are
+ * possible. Runs on engine thread and detaches the engine for the time
+ * of the search so that nothing is shown to the user.
+ */
+class EngineSolver
+{
+public:
+    struct Move {
+        enum Kind {
+            Drag,
+            Click,
+            Deal,
+        };
+
+        Kind kind;
+        int from;
+        int index;
+        int to;
+    };
+
+    struct Result {
+        Solver::Outcome outcome;
+        quint64 nodes;
+        quint64 deadEnds;
+        int depth;
+        qint64 msecs;
+        QVector<Move> solution;
+
+        Result();
+    };
+
+    explicit EngineSolver(EnginePrivate *engine);
+
+    Result solve(const Solver::Limits &limits);
+    void cancel();
+
+    static quint64 hash(const QHash<int, CardList> &slots);
+
+private:
+    enum Status {
+        Dead,
+        Won,
+        Aborted,
+    };
+
+    enum Applied {
+        Moved,
+        NotMoved,
+        Failed,
+    };
+
+    Status search(int depth);
+    bool candidates(QVector<Move> *moves);
+    Applied apply(const Move &move);
+
+    EnginePrivate *m_engine;
+    QAtomicInt m_canceled;
+    Solver::Limits m_limits;
+    QElapsedTimer m_timer;
+    QSet<quint64> m_visited;
+    QVector<Move> m_path;
+    quint64 m_nodes;
+    quint64 m_deadEnds;
+    bool m_budgetHit;
+};
+
+#endif // ENGINESOLVER_H
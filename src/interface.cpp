@@ -439,6 +439,11 @@ SCM Interface::delayedCall(SCM callback)
 {
     auto *engine = EnginePrivate::instance();
     qCDebug(lcScheme) << "Creating delayed call";
+    if (engine->isDetached()) {
+        engine->setPendingCall(callback);
+        return SCM_EOL;
+    }
+
     if (engine->m_delayedCallTimer) {
         return scm_throw(scm_from_locale_symbol("aisleriot-invalid-call"),
                          scm_list_1(scm_from_utf8_string("Already have a delayed callback pending.")));
@@ -450,8 +455,19 @@ SCM Interface::delayedCall(SCM callback)
         engine->m_delayedCallTimer->deleteLater();
         engine->m_delayedCallTimer = nullptr;
 
+        EnginePrivate::Snapshot snapshot;
+        if (!engine->takeRecoverySnapshot(&snapshot)) {
+            engine->die("Can not run delayed call");
+            return;
+        }
+
+        // Errors in the game are skipped like before, only interrupted
+        // calls leave changes behind that must be undone
         if (engine->makeSCMCall(callback, nullptr, 0, nullptr))
             engine->endMove(true);
+        else if (engine->timedOut())
+            engine->recover(snapshot);
+        engine->releaseSnapshot(&snapshot);
     });
     engine->m_delayedCallTimer->start(DelayedCallDelay);
     return SCM_EOL;
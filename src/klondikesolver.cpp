@@ -0,0 +1,346 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "klondikesolver.h"
+#include "logging.h"
+
+using namespace SolverCard;
+
+namespace {
+
+// Klondike and Saratoga have two groups of radio options, first three
+// or single card deals and then no, three or unlimited redeals. Indices
+// count the markers that begin and end the groups too.
+enum KlondikeOption : uint {
+    ThreeCardDeals = 1,
+    SingleCardDeals = 2,
+    NoRedeals = 5,
+    ThreeRedeals = 6,
+    UnlimitedRedeals = 7,
+};
+
+} // namespace
+
+KlondikeSolver::KlondikeSolver(const QString &name, const GameOptionList &options)
+    : m_dealCount(1)
+    , m_redeals(-1)
+    , m_sameColor(false)
+    , m_sameSuitRuns(false)
+    , m_kingsOnly(true)
+{
+    if (name == QStringLiteral("whitehead")) {
+        // Whitehead builds down by color, only moves suits and allows any
+        // card to be placed on an empty slot, single pass through the deck
+        m_redeals = 0;
+        m_sameColor = true;
+        m_sameSuitRuns = true;
+        m_kingsOnly = false;
+    } else if (!readOptions(options)) {
+        // Assuming too few cards or redeals could make a deal unsolvable
+        qCWarning(lcSolver) << "Unknown options for" << name << "assuming the most permissive rules";
+        m_dealCount = 1;
+        m_redeals = -1;
+    }
+
+    qCDebug(lcSolver) << "Created solver for" << name << "dealing" << m_dealCount
+                      << "cards with" << m_redeals << "redeals";
+}
+
+bool KlondikeSolver::readOptions(const GameOptionList &options)
+{
+    // Display names may be translated, options are told apart by their
+    // places in the list like in SeedDatabase::optionsMask
+    if (options.count() != 5)
+        return false;
+    for (const GameOption &option : options) {
+        if (!option.isRadioOption())
+            return false;
+        switch (option.index) {
+        case ThreeCardDeals:
+            if (option.set)
+                m_dealCount = 3;
+            break;
+        case SingleCardDeals:
+            if (option.set)
+                m_dealCount = 1;
+            break;
+        case NoRedeals:
+            if (option.set)
+                m_redeals = 0;
+            break;
+        case ThreeRedeals:
+            if (option.set)
+                m_redeals = 3;
+            break;
+        case UnlimitedRedeals:
+            if (option.set)
+                m_redeals = -1;
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+bool KlondikeSolver::supports(const QString &name)
+{
+    return name == QStringLiteral("klondike")
+        || name == QStringLiteral("saratoga")
+        || name == QStringLiteral("whitehead");
+}
+
+KlondikeSolver::Layout::Layout(const SolverPosition &position)
+    : stock(-1)
+    , waste(-1)
+{
+    for (size_t i = 0; i < position.types.size(); i++) {
+        switch (position.types[i]) {
+        case StockSlot:
+            stock = i;
+            break;
+        case WasteSlot:
+            waste = i;
+            break;
+        case FoundationSlot:
+            foundations.push_back(i);
+            break;
+        case TableauSlot:
+            tableau.push_back(i);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void KlondikeSolver::moves(const SolverPosition &position, std::vector<SolverMove> &moves) const
+{
+    Layout layout(position);
+
+    int foundationRanks[4] = { 0, 0, 0, 0 };
+    for (int foundation : layout.foundations) {
+        const SolverPile &pile = position.piles[foundation];
+        if (!pile.empty())
+            foundationRanks[suit(pile.back())] = rank(pile.back());
+    }
+
+    std::vector<SolverMove> toFoundation;
+    std::vector<SolverMove> revealing;
+    std::vector<SolverMove> others;
+    std::vector<SolverMove> late;
+
+    std::vector<int> sources(layout.tableau);
+    if (layout.waste >= 0)
+        sources.push_back(layout.waste);
+    for (int from : sources) {
+        const SolverPile &pile = position.piles[from];
+        if (pile.empty() || !faceUp(pile.back()))
+            continue;
+        int target = foundationFor(position, layout, pile.back());
+        if (target >= 0) {
+            SolverMove move = { SolverMove::Transfer, (quint8)from, (quint8)target, 1 };
+            if (isSafe(pile.back(), foundationRanks)) {
+                // There is no reason to consider anything else
+                moves.assign(1, move);
+                return;
+            }
+            toFoundation.push_back(move);
+        }
+    }
+
+    int emptyTableau = -1;
+    for (int target : layout.tableau) {
+        if (position.piles[target].empty()) {
+            emptyTableau = target;
+            break;
+        }
+    }
+
+    for (int from : layout.tableau) {
+        const SolverPile &pile = position.piles[from];
+        size_t first = pile.size();
+        while (first > 0 && faceUp(pile[first - 1]))
+            first--;
+        size_t start = first;
+        while (start < pile.size() && !isRun(pile, start))
+            start++;
+
+        for (size_t i = start; i < pile.size(); i++) {
+            quint8 card = pile[i];
+            bool reveals = i > 0 && !faceUp(pile[i - 1]);
+            // Splitting a run is mostly useful when the card below can go
+            // home, try other splits last
+            bool split = i > start && foundationFor(position, layout, pile[i - 1]) < 0;
+
+            for (int target : layout.tableau) {
+                const SolverPile &targetPile = position.piles[target];
+                if (target == from)
+                    continue;
+                if (targetPile.empty()) {
+                    if (target != emptyTableau || i == 0 || (m_kingsOnly && rank(card) != RankKing))
+                        continue;
+                } else if (!faceUp(targetPile.back()) || !buildsOn(card, targetPile.back())) {
+                    continue;
+                }
+                SolverMove move = { SolverMove::Transfer, (quint8)from, (quint8)target,
+                                    (quint8)(pile.size() - i) };
+                (split ? late : reveals ? revealing : others).push_back(move);
+            }
+        }
+    }
+
+    if (layout.waste >= 0 && !position.piles[layout.waste].empty()) {
+        quint8 card = position.piles[layout.waste].back();
+        for (int target : layout.tableau) {
+            const SolverPile &targetPile = position.piles[target];
+            if (targetPile.empty()) {
+                if (target != emptyTableau || (m_kingsOnly && rank(card) != RankKing))
+                    continue;
+            } else if (!faceUp(targetPile.back()) || !buildsOn(card, targetPile.back())) {
+                continue;
+            }
+            SolverMove move = { SolverMove::Transfer, (quint8)layout.waste, (quint8)target, 1 };
+            revealing.push_back(move);
+        }
+    }
+
+    for (int from : layout.foundations) {
+        const SolverPile &pile = position.piles[from];
+        if (pile.empty() || rank(pile.back()) <= RankTwo)
+            continue;
+        for (int target : layout.tableau) {
+            const SolverPile &targetPile = position.piles[target];
+            if (!targetPile.empty() && faceUp(targetPile.back())
+                    && buildsOn(pile.back(), targetPile.back())) {
+                SolverMove move = { SolverMove::Transfer, (quint8)from, (quint8)target, 1 };
+                late.push_back(move);
+            }
+        }
+    }
+
+    if (layout.stock >= 0 && layout.waste >= 0) {
+        const SolverPile &stock = position.piles[layout.stock];
+        if (!stock.empty()) {
+            SolverMove move = { SolverMove::Deal, (quint8)layout.stock, (quint8)layout.waste,
+                                (quint8)std::min<size_t>(m_dealCount, stock.size()) };
+            others.push_back(move);
+        } else if (!position.piles[layout.waste].empty() && position.redealsLeft != 0) {
+            SolverMove move = { SolverMove::Redeal, (quint8)layout.waste, (quint8)layout.stock, 0 };
+            others.push_back(move);
+        }
+    }
+
+    moves.clear();
+    moves.insert(moves.end(), toFoundation.begin(), toFoundation.end());
+    moves.insert(moves.end(), revealing.begin(), revealing.end());
+    moves.insert(moves.end(), others.begin(), others.end());
+    moves.insert(moves.end(), late.begin(), late.end());
+}
+
+void KlondikeSolver::apply(SolverPosition &position, const SolverMove &move) const
+{
+    SolverPile &from = position.piles[move.from];
+    SolverPile &to = position.piles[move.to];
+    switch (move.kind) {
+    case SolverMove::Transfer:
+        to.insert(to.end(), from.end() - move.count, from.end());
+        from.erase(from.end() - move.count, from.end());
+        if (position.types[move.from] == TableauSlot)
+            flipTop(from);
+        break;
+    case SolverMove::Deal:
+        for (int i = 0; i < move.count; i++) {
+            to.push_back(from.back() | FaceUp);
+            from.pop_back();
+        }
+        break;
+    case SolverMove::Redeal:
+        for (auto it = from.rbegin(); it != from.rend(); it++)
+            to.push_back(*it & ~FaceUp);
+        from.clear();
+        if (position.redealsLeft > 0)
+            position.redealsLeft--;
+        break;
+    }
+}
+
+bool KlondikeSolver::isWon(const SolverPosition &position) const
+{
+    for (size_t i = 0; i < position.piles.size(); i++) {
+        if (position.types[i] != FoundationSlot && !position.piles[i].empty())
+            return false;
+    }
+    return true;
+}
+
+void KlondikeSolver::prepare(SolverPosition &position) const
+{
+    // The engine does not tell how many redeals have been used
+    position.redealsLeft = m_redeals;
+}
+
+bool KlondikeSolver::buildsOn(quint8 card, quint8 target) const
+{
+    if (rank(target) != rank(card) + 1)
+        return false;
+    return m_sameColor ? isRed(card) == isRed(target) : isRed(card) != isRed(target);
+}
+
+bool KlondikeSolver::isRun(const SolverPile &pile, size_t first) const
+{
+    for (size_t i = first; i + 1 < pile.size(); i++) {
+        if (!faceUp(pile[i]) || !buildsOn(pile[i + 1], pile[i]))
+            return false;
+        if (m_sameSuitRuns && !sameSuit(pile[i], pile[i + 1]))
+            return false;
+    }
+    return first < pile.size() && faceUp(pile[first]);
+}
+
+bool KlondikeSolver::isSafe(quint8 card, const int *foundationRanks) const
+{
+    // Safe if every card that could be placed on it can go home as well
+    if (rank(card) <= RankTwo)
+        return true;
+    for (int other = SuitClubs; other <= SuitSpade; other++) {
+        if (other == suit(card))
+            continue;
+        bool otherRed = other == SuitDiamonds || other == SuitHeart;
+        if ((otherRed == isRed(card)) != m_sameColor)
+            continue;
+        if (foundationRanks[other] < rank(card) - 1)
+            return false;
+    }
+    return true;
+}
+
+int KlondikeSolver::foundationFor(const SolverPosition &position, const Layout &layout, quint8 card) const
+{
+    int empty = -1;
+    for (int foundation : layout.foundations) {
+        const SolverPile &pile = position.piles[foundation];
+        if (pile.empty()) {
+            if (empty < 0)
+                empty = foundation;
+        } else if (sameSuit(pile.back(), card) && rank(pile.back()) + 1 == rank(card)) {
+            return foundation;
+        }
+    }
+    return rank(card) == RankAce ? empty : -1;
+}
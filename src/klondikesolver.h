@@ -0,0 +1,63 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KLONDIKESOLVER_H
+#define KLONDIKESOLVER_H
+
+#include "solver.h"
+
+/*
+ * Solver for Klondike, Saratoga and Whitehead.
+ */
+class KlondikeSolver : public Solver
+{
+public:
+    KlondikeSolver(const QString &name, const GameOptionList &options);
+
+    static bool supports(const QString &name);
+
+    void moves(const SolverPosition &position, std::vector<SolverMove> &moves) const;
+    void apply(SolverPosition &position, const SolverMove &move) const;
+    bool isWon(const SolverPosition &position) const;
+
+protected:
+    void prepare(SolverPosition &position) const;
+
+private:
+    struct Layout {
+        int stock;
+        int waste;
+        std::vector<int> foundations;
+        std::vector<int> tableau;
+
+        explicit Layout(const SolverPosition &position);
+    };
+
+    bool readOptions(const GameOptionList &options);
+    bool buildsOn(quint8 card, quint8 target) const;
+    bool isRun(const SolverPile &pile, size_t first) const;
+    bool isSafe(quint8 card, const int *foundationRanks) const;
+    int foundationFor(const SolverPosition &position, const Layout &layout, quint8 card) const;
+
+    int m_dealCount;
+    int m_redeals;
+    bool m_sameColor;
+    bool m_sameSuitRuns;
+    bool m_kingsOnly;
+};
+
+#endif // KLONDIKESOLVER_H
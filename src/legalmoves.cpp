@@ -0,0 +1,163 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "engine_p.h"
+#include "interface.h"
+#include "legalmoves.h"
+#include "logging.h"
+
+namespace {
+
+const quint64 VariableHashSize = 0x7fffffff;
+
+} // namespace
+
+LegalMoves::LegalMoves(EnginePrivate *engine)
+    : m_engine(engine)
+    , m_valid(false)
+    , m_signature(0)
+{
+}
+
+bool LegalMoves::moves(MoveList *moves)
+{
+    // Without droppable lambda the only way to know is to drop
+    if (!m_engine->hasFeature(EnginePrivate::FeatureDroppable))
+        return true;
+
+    quint64 current;
+    if (!signature(&current))
+        return false;
+
+    QList<int> ids = m_engine->m_cardSlots.keys();
+    std::sort(ids.begin(), ids.end());
+
+    if (!m_valid || current != m_signature) {
+        m_draggable.clear();
+        m_moves.clear();
+        m_changed = ids.toSet();
+        m_signature = current;
+        m_valid = true;
+    }
+
+    if (!m_changed.isEmpty()) {
+        qCDebug(lcEngine) << "Updating legal moves of" << m_changed.count() << "slots";
+        QList<int> changed = m_changed.toList();
+        std::sort(changed.begin(), changed.end());
+
+        for (int id : ids) {
+            if (m_changed.contains(id)) {
+                QList<int> indices;
+                if (!draggable(id, &indices))
+                    return false;
+                m_draggable[id] = indices;
+                m_moves[id].clear();
+                if (!check(id, ids, &m_moves[id]))
+                    return false;
+            } else {
+                // Only drops to changed slots may have changed
+                MoveList &list = m_moves[id];
+                list.erase(std::remove_if(list.begin(), list.end(), [this](const MoveData &move) {
+                    return m_changed.contains(move.to);
+                }), list.end());
+                if (!check(id, changed, &list))
+                    return false;
+                std::sort(list.begin(), list.end(), [](const MoveData &a, const MoveData &b) {
+                    return a.index != b.index ? a.index > b.index : a.to < b.to;
+                });
+            }
+        }
+        m_changed.clear();
+    }
+
+    for (int id : ids)
+        moves->append(m_moves.value(id));
+    return true;
+}
+
+void LegalMoves::invalidate(int slotId)
+{
+    m_changed.insert(slotId);
+}
+
+void LegalMoves::invalidateAll()
+{
+    m_valid = false;
+}
+
+bool LegalMoves::signature(quint64 *signature)
+{
+    SCM variables;
+    if (!m_engine->makeSCMCall(QStringLiteral("save-variables"), nullptr, 0, &variables))
+        return false;
+
+    int empty = 0;
+    for (const CardList &cards : m_engine->m_cardSlots) {
+        if (cards.isEmpty())
+            empty++;
+    }
+    *signature = (scm_to_uint64(scm_hash(variables, scm_from_uint64(VariableHashSize))) << 16) ^ empty;
+    return true;
+}
+
+bool LegalMoves::draggable(int slotId, QList<int> *indices)
+{
+    const CardList cards = m_engine->m_cardSlots.value(slotId);
+    for (int index = cards.count() - 1; index >= 0 && cards[index].show; index--) {
+        SCM args[2];
+        args[0] = scm_from_int(slotId);
+        args[1] = Scheme::slotToSCM(cards.mid(index));
+        SCM rv;
+        if (!m_engine->makeSCMCall(EnginePrivate::ButtonPressedLambda, args, 2, &rv))
+            return false;
+        scm_remember_upto_here_2(args[0], args[1]);
+        if (scm_is_true(rv))
+            indices->append(index);
+    }
+    return true;
+}
+
+bool LegalMoves::droppable(int from, int index, int to, bool *could)
+{
+    SCM args[3];
+    args[0] = scm_from_int(from);
+    args[1] = Scheme::slotToSCM(m_engine->m_cardSlots.value(from).mid(index));
+    args[2] = scm_from_int(to);
+    SCM rv;
+    if (!m_engine->makeSCMCall(EnginePrivate::DroppableLambda, args, 3, &rv))
+        return false;
+    scm_remember_upto_here(args[0], args[1], args[2]);
+    *could = scm_is_true(rv);
+    return true;
+}
+
+bool LegalMoves::check(int from, const QList<int> &targets, MoveList *moves)
+{
+    for (int index : m_draggable.value(from)) {
+        for (int to : targets) {
+            bool could;
+            if (to == from)
+                continue;
+            if (!droppable(from, index, to, &could))
+                return false;
+            if (could)
+                moves->append({ from, index, to });
+        }
+    }
+    return true;
+}
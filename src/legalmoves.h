@@ -0,0 +1,58 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LEGALMOVES_H
+#define LEGALMOVES_H
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include "enginedata.h"
+
+class EnginePrivate;
+
+/*
+ * Keeps the list of cards that can be dragged and where they can be
+ * dropped. Slots are marked changed as their cards change and only moves
+ * from or to changed slots are asked from the game again. Everything is
+ * checked again if game variables or the number of empty slots change,
+ * as rules such as free cell counts depend on them.
+ */
+class LegalMoves
+{
+public:
+    explicit LegalMoves(EnginePrivate *engine);
+
+    bool moves(MoveList *moves);
+    void invalidate(int slotId);
+    void invalidateAll();
+
+private:
+    bool signature(quint64 *signature);
+    bool draggable(int slotId, QList<int> *indices);
+    bool droppable(int from, int index, int to, bool *could);
+    bool check(int from, const QList<int> &targets, MoveList *moves);
+
+    EnginePrivate *m_engine;
+    QHash<int, QList<int>> m_draggable;
+    QHash<int, MoveList> m_moves;
+    QSet<int> m_changed;
+    bool m_valid;
+    quint64 m_signature;
+};
+
+#endif // LEGALMOVES_H
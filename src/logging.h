@@ -31,6 +31,8 @@ Q_DECLARE_LOGGING_CATEGORY(lcTimer);
 Q_DECLARE_LOGGING_CATEGORY(lcMouse);
 Q_DECLARE_LOGGING_CATEGORY(lcEngine);
 Q_DECLARE_LOGGING_CATEGORY(lcOptions);
+Q_DECLARE_LOGGING_CATEGORY(lcSolver);
+Q_DECLARE_LOGGING_CATEGORY(lcSeeds);
 Q_DECLARE_LOGGING_CATEGORY(lcScheme);
 
 #endif // LOGGING_H
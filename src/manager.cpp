@@ -34,6 +34,11 @@ Manager::Manager(Table *table)
     connect(engine, &Engine::moveEnded, this, &Manager::handleMoveEnded);
 }
 
+Manager::~Manager()
+{
+    qDeleteAll(m_cards);
+}
+
 bool Manager::preparing() const
 {
     return m_preparing;
@@ -51,7 +56,7 @@ void Manager::handleNewSlot(int id, const CardList &dataList, int type,
         if (!dataList.isEmpty()) {
             QList<Card *> cards;
             for (const CardData &data : dataList) {
-                auto card = new Card(data, m_table, slot, this);
+                auto card = new Card(data, m_table);
                 cards.append(card);
             }
             slot->put(cards);
@@ -68,15 +73,13 @@ void Manager::handleAction(Engine::ActionType action, int slotId, int index, con
         switch (action) {
         case Engine::InsertionAction:
             {
-                Card *card = new Card(data, m_table, slot, this);
+                Card *card = new Card(data, m_table);
                 slot->insert(index, card);
                 break;
             }
         case Engine::RemovalAction:
             {
-                Card *card = slot->takeAt(index);
-                card->setParentItem(nullptr);
-                card->deleteLater();
+                delete slot->takeAt(index);
                 break;
             }
         case Engine::FlippingAction:
@@ -87,11 +90,7 @@ void Manager::handleAction(Engine::ActionType action, int slotId, int index, con
             }
         case Engine::ClearingAction:
             {
-                auto cards = slot->takeAll();
-                for (Card *card : cards) {
-                    card->setParentItem(nullptr);
-                    card->deleteLater();
-                }
+                qDeleteAll(slot->takeAll());
                 break;
             }
         }
@@ -105,18 +104,14 @@ void Manager::handleClearData()
     m_preparing = true;
     for (int slotId : *m_table) {
         Slot *slot = m_table->slot(slotId);
-        auto cards = slot->takeAll();
-        for (Card *card : cards) {
-            card->setParentItem(nullptr);
-            card->deleteLater();
-        }
+        qDeleteAll(slot->takeAll());
         slot->setParentItem(nullptr);
         slot->deleteLater();
     }
     m_table->clear();
-    for (Card *card : m_cards)
-        card->deleteLater();
+    qDeleteAll(m_cards);
     m_cards.clear();
+    m_placed.clear();
     m_actions.clear();
     qCDebug(lcManager) << "Started preparing while storing" << m_cards.count()
                        << "for" << actionCount() << "actions";
@@ -134,6 +129,20 @@ void Manager::handleMoveEnded()
 {
     dequeue();
 
+    if (!m_placed.isEmpty()) {
+        qCWarning(lcManager) << "There were still" << m_placed.count()
+                             << "placed cards that engine did not insert when move ended!";
+        for (Card *card : m_placed.values()) {
+            Slot *slot = card->slot();
+            if (slot && slot->contains(card))
+                slot->takeAt(slot->constFind(card) - slot->constBegin());
+            store(card);
+        }
+    }
+
+    // All slots touched by the move are laid out once
+    m_table->layoutSlots();
+
     int count = 0;
     for (const auto list : m_actions)
         count += list.count();
@@ -154,6 +163,7 @@ void Manager::handleMoveEnded()
 void Manager::store(Card *card)
 {
     qCDebug(lcManager) << "Storing" << *card;
+    forgetPlaced(card);
     card->setParentItem(nullptr);
     m_cards.insertMulti(SuitAndRank(card->suit(), card->rank()), card);
 }
@@ -164,6 +174,67 @@ void Manager::store(const QList<Card *> &cards)
         store(card);
 }
 
+void Manager::place(Slot *slot, const QList<Card *> &cards)
+{
+    // Cards stay on top of the slot until engine's actions for the move
+    // are dequeued, engine's indices refer to the cards below them
+    slot->put(cards);
+    for (Card *card : cards)
+        m_placed.insertMulti(SuitAndRank(card->suit(), card->rank()), card);
+}
+
+void Manager::unplace(Slot *slot, const QList<Card *> &cards)
+{
+    if (!cards.isEmpty() && slot->contains(cards.first()))
+        slot->take(cards.first());
+    for (Card *card : cards) {
+        forgetPlaced(card);
+        // Engine may have already moved or stored the card when it recovered
+        Slot *current = card->slot();
+        if (current && current->contains(card))
+            current->takeAt(current->constFind(card) - current->constBegin());
+        SuitAndRank suitAndRank(card->suit(), card->rank());
+        for (auto it = m_cards.find(suitAndRank); it != m_cards.end() && it.key() == suitAndRank; ++it) {
+            if (it.value() == card) {
+                m_cards.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+bool Manager::isPlaced(Card *card) const
+{
+    for (auto it = m_placed.constFind(SuitAndRank(card->suit(), card->rank()));
+         it != m_placed.constEnd() && it.key() == SuitAndRank(card->suit(), card->rank()); ++it) {
+        if (it.value() == card)
+            return true;
+    }
+    return false;
+}
+
+Card *Manager::takePlaced(const SuitAndRank &suitAndRank)
+{
+    Card *card = m_placed.take(suitAndRank);
+    if (card) {
+        Slot *slot = card->slot();
+        if (slot && slot->contains(card))
+            slot->takeAt(slot->constFind(card) - slot->constBegin());
+    }
+    return card;
+}
+
+void Manager::forgetPlaced(Card *card)
+{
+    SuitAndRank suitAndRank(card->suit(), card->rank());
+    for (auto it = m_placed.find(suitAndRank); it != m_placed.end() && it.key() == suitAndRank; ++it) {
+        if (it.value() == card) {
+            m_placed.erase(it);
+            break;
+        }
+    }
+}
+
 void Manager::queue(Engine::ActionType type, int slotId, int index, const CardData &data)
 {
     Action action(type, slotId, index, data);
@@ -211,14 +282,16 @@ bool Manager::handle(Slot *slot, const Action *action) {
     qCDebug(lcManager) << "Dequeueing" << *action;
     switch (action->type) {
     case Engine::InsertionAction:
-        if (m_cards.contains(action->suitAndRank())) {
-            Card *card = m_cards.take(action->suitAndRank());
+        if (m_placed.contains(action->suitAndRank()) || m_cards.contains(action->suitAndRank())) {
+            // Prefer cards that were already placed in anticipation of this
+            Card *card = takePlaced(action->suitAndRank());
+            if (!card)
+                card = m_cards.take(action->suitAndRank());
             card->setShow(action->data.show);
             if (action->index == -1)
                 slot->append(card);
             else
                 slot->insert(action->index, card);
-            card->update();
             handled = true;
         }
         break;
@@ -241,7 +314,6 @@ bool Manager::handle(Slot *slot, const Action *action) {
                 qCCritical(lcManager) << "Rank or suit doesn't match to" << action->data
                                       << "for card" << *card << "in slot" << action->slot
                                       << "at index" << action->index;
-            card->update();
             handled = true;
             break;
         }
@@ -34,9 +34,13 @@ class Manager : public QObject
     Q_OBJECT
 public:
     explicit Manager(Table *table);
+    ~Manager();
 
     bool preparing() const;
     void store(const QList<Card *> &cards);
+    void place(Slot *slot, const QList<Card *> &cards);
+    void unplace(Slot *slot, const QList<Card *> &cards);
+    bool isPlaced(Card *card) const;
 
 private slots:
     void handleNewSlot(int id, const CardList &cards, int type, double x, double y,
@@ -63,6 +67,8 @@ private:
     friend QDebug operator<<(QDebug debug, const Manager::Action &action);
 
     void store(Card *card);
+    Card *takePlaced(const SuitAndRank &suitAndRank);
+    void forgetPlaced(Card *card);
     void queue(Engine::ActionType type, int slotId, int index, const CardData &data);
     const Action *nextAction(int slot) const;
     void discardAction(int slot);
@@ -74,6 +80,7 @@ private:
     Table *m_table;
     bool m_preparing;
     QHash<SuitAndRank, Card *> m_cards;
+    QHash<SuitAndRank, Card *> m_placed;
     QHash<int, QLinkedList<Action>> m_actions;
 };
 
@@ -23,11 +23,19 @@
 #include <memory>
 #include "patience.h"
 #include "constants.h"
+#include "drag.h"
 #include "gamelist.h"
 #include "logging.h"
 
 const QString Constants::ConfPath = QStringLiteral("/site/tomin/apps/PatienceDeck");
 const QString HistoryConf = QStringLiteral("/history");
+const QString DealFilterConf = QStringLiteral("/dealFilter");
+const QString HighlightTargetsConf = QStringLiteral("/highlightTargets");
+const QString TapToMoveConf = QStringLiteral("/tapToMove");
+const QString CallBudgetConf = QStringLiteral("/callBudget");
+const QString CallStatsConf = QStringLiteral("/callStats");
+const QString TextureBudgetConf = QStringLiteral("/textureBudget");
+const int DefaultTextureBudget = 32; // MiB
 
 Patience* Patience::s_game = nullptr;
 
@@ -51,11 +59,23 @@ Patience::Patience(QObject *parent)
     , m_canUndo(false)
     , m_canRedo(false)
     , m_canDeal(false)
+    , m_canAutoComplete(false)
     , m_showDeal(false)
     , m_score(0)
     , m_showScore(false)
     , m_state(UninitializedState)
+    , m_dealRating(UnknownRating)
+    , m_positionLost(false)
+    , m_hasSeedDatabase(false)
+    , m_hintId(0)
+    , m_callStatsId(0)
     , m_historyConf(Constants::ConfPath + HistoryConf)
+    , m_dealFilterConf(Constants::ConfPath + DealFilterConf)
+    , m_highlightTargetsConf(Constants::ConfPath + HighlightTargetsConf)
+    , m_tapToMoveConf(Constants::ConfPath + TapToMoveConf)
+    , m_callBudgetConf(Constants::ConfPath + CallBudgetConf)
+    , m_callStatsConf(Constants::ConfPath + CallStatsConf)
+    , m_textureBudgetConf(Constants::ConfPath + TextureBudgetConf)
 {
     auto engine = Engine::instance();
     engine->moveToThread(&m_engineThread);
@@ -68,14 +88,19 @@ Patience::Patience(QObject *parent)
     connect(engine, &Engine::canUndo, this, &Patience::handleCanUndoChanged);
     connect(engine, &Engine::canRedo, this, &Patience::handleCanRedoChanged);
     connect(engine, &Engine::canDeal, this, &Patience::handleCanDealChanged);
+    connect(engine, &Engine::canAutoComplete, this, &Patience::handleCanAutoCompleteChanged);
     connect(engine, &Engine::score, this, &Patience::handleScoreChanged);
     connect(engine, &Engine::message, this, &Patience::handleMessageChanged);
-    connect(engine, &Engine::hint, this, &Patience::hint);
+    connect(engine, &Engine::hint, this, &Patience::handleHint);
+    connect(engine, &Engine::callStats, this, &Patience::handleCallStats);
     connect(engine, &Engine::showScore, this, &Patience::handleShowScore);
     connect(engine, &Engine::showDeal, this, &Patience::handleShowDeal);
     connect(engine, &Engine::moveEnded, this, &Patience::cardMoved);
     connect(engine, &Engine::restoreCompleted, this, &Patience::handleRestoreCompleted);
     connect(engine, &Engine::engineFailure, this, &Patience::catchFailure);
+    connect(engine, &Engine::dealRated, this, &Patience::handleDealRated);
+    connect(engine, &Engine::positionLost, this, &Patience::handlePositionLost);
+    connect(engine, &Engine::seedDatabaseAvailable, this, &Patience::handleSeedDatabaseAvailable);
     connect(this, &Patience::cardMoved, this, &Patience::handleCardMoved);
     connect(this, &Patience::doStart, engine, &Engine::start);
     connect(this, &Patience::doRestart, engine, &Engine::restart);
@@ -83,14 +108,36 @@ Patience::Patience(QObject *parent)
     connect(this, &Patience::doUndoMove, engine, &Engine::undoMove);
     connect(this, &Patience::doRedoMove, engine, &Engine::redoMove);
     connect(this, &Patience::doDealCard, engine, &Engine::dealCard);
+    connect(this, &Patience::doAutoPlay, engine, &Engine::autoPlay);
     connect(this, &Patience::doGetHint, engine, &Engine::getHint);
     connect(this, &Patience::doSaveEngineState, engine, &Engine::saveState);
     connect(this, &Patience::doResetSavedEngineState, engine, &Engine::resetSavedState);
     connect(this, &Patience::doRestoreSavedEngineState, engine, &Engine::restoreSavedState);
+    connect(this, &Patience::doSetDealFilter, engine, &Engine::setDealFilter);
+    connect(this, &Patience::doSetCallBudget, engine, &Engine::setCallBudget);
+    connect(this, &Patience::doSetCallStatsEnabled, engine, &Engine::setCallStatsEnabled);
+    connect(this, &Patience::doRequestCallStats, engine, &Engine::requestCallStats);
     connect(&m_historyConf, &MGConfItem::valueChanged, this, [&] {
         qCDebug(lcPatience) << "Saved history:" << m_historyConf.value().toString();
     });
     connect(&m_historyConf, &MGConfItem::valueChanged, this, &Patience::historyChanged);
+    connect(&m_dealFilterConf, &MGConfItem::valueChanged, this, [&] {
+        emit doSetDealFilter(dealFilter());
+        emit dealFilterChanged();
+    });
+    emit doSetDealFilter(dealFilter());
+    connect(&m_callBudgetConf, &MGConfItem::valueChanged, this, [&] {
+        emit doSetCallBudget(m_callBudgetConf.value(-1).toInt());
+    });
+    emit doSetCallBudget(m_callBudgetConf.value(-1).toInt());
+    connect(&m_callStatsConf, &MGConfItem::valueChanged, this, [&] {
+        emit doSetCallStatsEnabled(callStatsEnabled());
+        emit callStatsEnabledChanged();
+    });
+    emit doSetCallStatsEnabled(callStatsEnabled());
+    connect(&m_highlightTargetsConf, &MGConfItem::valueChanged, this, &Patience::highlightTargetsChanged);
+    connect(&m_tapToMoveConf, &MGConfItem::valueChanged, this, &Patience::tapToMoveChanged);
+    connect(&m_textureBudgetConf, &MGConfItem::valueChanged, this, &Patience::textureBudgetChanged);
     connect(&m_timer, &Timer::tick, this, &Patience::elapsedTimeChanged);
     connect(&m_timer, &Timer::statusChanged, this, &Patience::pausedChanged);
     m_engineThread.start();
@@ -141,6 +188,18 @@ void Patience::dealCard()
         emit doDealCard();
 }
 
+void Patience::playToFoundations()
+{
+    qCDebug(lcPatience) << "Playing safe cards to foundations";
+    emit doAutoPlay(false);
+}
+
+void Patience::autoComplete()
+{
+    if (m_canAutoComplete)
+        emit doAutoPlay(true);
+}
+
 bool Patience::canUndo() const
 {
     return m_canUndo;
@@ -156,6 +215,11 @@ bool Patience::canDeal() const
     return m_canDeal;
 }
 
+bool Patience::canAutoComplete() const
+{
+    return m_canAutoComplete;
+}
+
 bool Patience::showDeal() const
 {
     return m_showDeal;
@@ -188,7 +252,7 @@ QString Patience::helpFile() const
 
 void Patience::getHint()
 {
-    emit doGetHint();
+    emit doGetHint(++m_hintId);
 }
 
 int Patience::score() const
@@ -311,6 +375,80 @@ int Patience::gamesCount() const
     return GameList::supportedCount();
 }
 
+Patience::DealRating Patience::dealRating() const
+{
+    return m_dealRating;
+}
+
+bool Patience::positionLost() const
+{
+    return m_positionLost;
+}
+
+bool Patience::hasSeedDatabase() const
+{
+    return m_hasSeedDatabase;
+}
+
+Patience::DealFilter Patience::dealFilter() const
+{
+    return static_cast<DealFilter>(m_dealFilterConf.value(AnyDeal).toInt());
+}
+
+void Patience::setDealFilter(DealFilter filter)
+{
+    if (dealFilter() != filter) {
+        qCDebug(lcPatience) << "Setting deal filter to" << filter;
+        m_dealFilterConf.set(filter);
+    }
+}
+
+void Patience::requestCallStats()
+{
+    emit doRequestCallStats(++m_callStatsId);
+}
+
+QVariantMap Patience::placementStats() const
+{
+    return Drag::placementStats();
+}
+
+bool Patience::callStatsEnabled() const
+{
+    return m_callStatsConf.value(false).toBool();
+}
+
+int Patience::textureBudget() const
+{
+    return m_textureBudgetConf.value(DefaultTextureBudget).toInt();
+}
+
+bool Patience::highlightTargets() const
+{
+    return m_highlightTargetsConf.value(false).toBool();
+}
+
+void Patience::setHighlightTargets(bool highlightTargets)
+{
+    if (this->highlightTargets() != highlightTargets) {
+        qCDebug(lcPatience) << "Setting highlighting of targets to" << highlightTargets;
+        m_highlightTargetsConf.set(highlightTargets);
+    }
+}
+
+bool Patience::tapToMove() const
+{
+    return m_tapToMoveConf.value(false).toBool();
+}
+
+void Patience::setTapToMove(bool tapToMove)
+{
+    if (this->tapToMove() != tapToMove) {
+        qCDebug(lcPatience) << "Setting tap to move to" << tapToMove;
+        m_tapToMoveConf.set(tapToMove);
+    }
+}
+
 void Patience::restoreSavedOrLoad(const QString &fallback)
 {
     m_gameFile = fallback + '-';
@@ -330,6 +468,47 @@ void Patience::catchFailure(QString message) {
     m_timer.stop();
 }
 
+void Patience::handleDealRated(int rating)
+{
+    if (m_dealRating != rating) {
+        qCDebug(lcPatience) << "Deal rating is now" << rating;
+        m_dealRating = static_cast<DealRating>(rating);
+        emit dealRatingChanged();
+    }
+}
+
+void Patience::handlePositionLost(bool lost)
+{
+    if (m_positionLost != lost) {
+        qCDebug(lcPatience) << "Position" << (lost ? "is" : "is not") << "lost";
+        m_positionLost = lost;
+        emit positionLostChanged();
+    }
+}
+
+void Patience::handleSeedDatabaseAvailable(bool available)
+{
+    if (m_hasSeedDatabase != available) {
+        qCDebug(lcPatience) << "Seed database is" << (available ? "available" : "not available");
+        m_hasSeedDatabase = available;
+        emit hasSeedDatabaseChanged();
+    }
+}
+
+void Patience::handleCallStats(quint32 id, const QVariantMap &stats)
+{
+    // Only the latest request is interesting
+    if (id == m_callStatsId)
+        emit callStats(stats);
+}
+
+void Patience::handleHint(quint32 id, const QString &hint)
+{
+    // Only the latest request is interesting
+    if (id == m_hintId)
+        emit this->hint(hint);
+}
+
 void Patience::handleGameLoaded(const QString &gameFile)
 {
     qCDebug(lcPatience) << "Loaded game" << gameFile;
@@ -406,6 +585,15 @@ void Patience::handleCanDealChanged(bool canDeal)
     }
 }
 
+void Patience::handleCanAutoCompleteChanged(bool canAutoComplete)
+{
+    if (m_canAutoComplete != canAutoComplete) {
+        qCDebug(lcPatience) << (canAutoComplete ? "Can" : "Can't") << "auto complete";
+        m_canAutoComplete = canAutoComplete;
+        emit canAutoCompleteChanged();
+    }
+}
+
 void Patience::handleScoreChanged(int score)
 {
     if (m_score != score) {
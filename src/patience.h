@@ -33,6 +33,7 @@ class Patience : public QObject
     Q_PROPERTY(bool canUndo READ canUndo NOTIFY canUndoChanged)
     Q_PROPERTY(bool canRedo READ canRedo NOTIFY canRedoChanged)
     Q_PROPERTY(bool canDeal READ canDeal NOTIFY canDealChanged)
+    Q_PROPERTY(bool canAutoComplete READ canAutoComplete NOTIFY canAutoCompleteChanged)
     Q_PROPERTY(int score READ score NOTIFY scoreChanged)
     Q_PROPERTY(QString elapsedTime READ elapsedTime NOTIFY elapsedTimeChanged)
     Q_PROPERTY(int state READ state NOTIFY stateChanged)
@@ -47,6 +48,15 @@ class Patience : public QObject
     Q_PROPERTY(bool engineFailed READ engineFailed NOTIFY engineFailedChanged)
     Q_PROPERTY(QString helpFile READ helpFile NOTIFY gameNameChanged)
     Q_PROPERTY(int gamesCount READ gamesCount CONSTANT)
+    Q_PROPERTY(DealRating dealRating READ dealRating NOTIFY dealRatingChanged)
+    Q_PROPERTY(bool positionLost READ positionLost NOTIFY positionLostChanged)
+    Q_PROPERTY(DealFilter dealFilter READ dealFilter WRITE setDealFilter NOTIFY dealFilterChanged)
+    Q_PROPERTY(bool hasSeedDatabase READ hasSeedDatabase NOTIFY hasSeedDatabaseChanged)
+    Q_PROPERTY(bool highlightTargets READ highlightTargets WRITE setHighlightTargets
+               NOTIFY highlightTargetsChanged)
+    Q_PROPERTY(bool tapToMove READ tapToMove WRITE setTapToMove NOTIFY tapToMoveChanged)
+    Q_PROPERTY(bool callStatsEnabled READ callStatsEnabled NOTIFY callStatsEnabledChanged)
+    Q_PROPERTY(int textureBudget READ textureBudget NOTIFY textureBudgetChanged)
 
 public:
     static Patience* instance();
@@ -63,6 +73,25 @@ public:
     };
     Q_ENUM(GameState);
 
+    enum DealRating {
+        UnknownRating,
+        EasyRating,
+        MediumRating,
+        HardRating,
+        UnwinnableRating,
+    };
+    Q_ENUM(DealRating);
+
+    // Same values as in SeedDatabase::Filter
+    enum DealFilter {
+        AnyDeal,
+        WinnableDeal,
+        EasyDeal,
+        MediumDeal,
+        HardDeal,
+    };
+    Q_ENUM(DealFilter);
+
     // QML API
     Q_INVOKABLE void startNewGame();
     Q_INVOKABLE void restartGame();
@@ -70,14 +99,19 @@ public:
     Q_INVOKABLE void undoMove();
     Q_INVOKABLE void redoMove();
     Q_INVOKABLE void dealCard();
+    Q_INVOKABLE void playToFoundations();
+    Q_INVOKABLE void autoComplete();
     Q_INVOKABLE void getHint();
     Q_INVOKABLE void restoreSavedOrLoad(const QString &fallback);
     Q_INVOKABLE QString getIconPath(int size) const;
+    Q_INVOKABLE void requestCallStats();
+    Q_INVOKABLE QVariantMap placementStats() const;
 
     // Properties
     bool canUndo() const;
     bool canRedo() const;
     bool canDeal() const;
+    bool canAutoComplete() const;
     bool showDeal() const;
     QString gameName() const;
     QString gameFile() const;
@@ -95,11 +129,23 @@ public:
     QStringList history() const;
     bool engineFailed() const;
     int gamesCount() const;
+    DealRating dealRating() const;
+    bool positionLost() const;
+    DealFilter dealFilter() const;
+    void setDealFilter(DealFilter filter);
+    bool hasSeedDatabase() const;
+    bool highlightTargets() const;
+    void setHighlightTargets(bool highlightTargets);
+    bool tapToMove() const;
+    void setTapToMove(bool tapToMove);
+    bool callStatsEnabled() const;
+    int textureBudget() const;
 
 signals:
     void canUndoChanged();
     void canRedoChanged();
     void canDealChanged();
+    void canAutoCompleteChanged();
     void scoreChanged();
     void elapsedTimeChanged();
     void stateChanged();
@@ -113,6 +159,15 @@ signals:
     void showAllGamesChanged();
     void historyChanged();
     void engineFailedChanged();
+    void dealRatingChanged();
+    void positionLostChanged();
+    void dealFilterChanged();
+    void hasSeedDatabaseChanged();
+    void highlightTargetsChanged();
+    void tapToMoveChanged();
+    void callStatsEnabledChanged();
+    void textureBudgetChanged();
+    void callStats(const QVariantMap &stats);
 
     void doStart();
     void doRestart();
@@ -120,10 +175,15 @@ signals:
     void doUndoMove();
     void doRedoMove();
     void doDealCard();
-    void doGetHint();
+    void doAutoPlay(bool all);
+    void doGetHint(quint32 id);
     void doSaveEngineState();
     void doResetSavedEngineState();
     void doRestoreSavedEngineState();
+    void doSetDealFilter(int filter);
+    void doSetCallBudget(int msecs);
+    void doSetCallStatsEnabled(bool enabled);
+    void doRequestCallStats(quint32 id);
 
 private slots:
     void catchFailure(QString message);
@@ -135,11 +195,17 @@ private slots:
     void handleCanUndoChanged(bool canUndo);
     void handleCanRedoChanged(bool canRedo);
     void handleCanDealChanged(bool canDeal);
+    void handleCanAutoCompleteChanged(bool canAutoComplete);
     void handleScoreChanged(int score);
     void handleMessageChanged(const QString &message);
     void handleShowScore(bool show);
     void handleShowDeal(bool show);
     void handleRestoreCompleted(bool success);
+    void handleDealRated(int rating);
+    void handlePositionLost(bool lost);
+    void handleSeedDatabaseAvailable(bool available);
+    void handleHint(quint32 id, const QString &hint);
+    void handleCallStats(quint32 id, const QVariantMap &stats);
 
 private:
     explicit Patience(QObject *parent = nullptr);
@@ -150,13 +216,25 @@ private:
     bool m_canUndo;
     bool m_canRedo;
     bool m_canDeal;
+    bool m_canAutoComplete;
     bool m_showDeal;
     int m_score;
     bool m_showScore;
     GameState m_state;
     QString m_gameFile;
     QString m_message;
+    DealRating m_dealRating;
+    bool m_positionLost;
+    bool m_hasSeedDatabase;
+    quint32 m_hintId;
+    quint32 m_callStatsId;
     MGConfItem m_historyConf;
+    MGConfItem m_dealFilterConf;
+    MGConfItem m_highlightTargetsConf;
+    MGConfItem m_tapToMoveConf;
+    MGConfItem m_callBudgetConf;
+    MGConfItem m_callStatsConf;
+    MGConfItem m_textureBudgetConf;
     Timer m_timer;
 
     static Patience *s_game;
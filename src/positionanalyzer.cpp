@@ -0,0 +1,71 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QMetaObject>
+#include <QThread>
+#include "engine.h"
+#include "logging.h"
+#include "positionanalyzer.h"
+#include "solvercache.h"
+
+namespace {
+
+const qint64 AnalysisTimeLimit = 2000;
+// Keeps the transposition table at 8 MiB
+const quint64 AnalysisNodeLimit = 500000;
+
+} // namespace
+
+PositionAnalyzer::PositionAnalyzer(QSharedPointer<Solver> solver, const SolverPosition &position,
+                                   quint64 gameKey, quint32 generation)
+    : m_solver(solver)
+    , m_position(position)
+    , m_gameKey(gameKey)
+    , m_generation(generation)
+{
+}
+
+void PositionAnalyzer::run()
+{
+    Solver::Limits limits;
+    limits.msecs = AnalysisTimeLimit;
+    limits.nodes = AnalysisNodeLimit;
+    // Leave a core for the user interface
+    limits.threads = qMax(1, QThread::idealThreadCount() - 1);
+
+    Solver::Result result = m_solver->solve(m_position, limits);
+    if (m_solver->isCanceled())
+        return;
+    SolverCache::instance()->insert(m_gameKey, SolverCache::positionKey(m_position), result);
+
+    // The solver sees cards facing down, telling that the game is lost
+    // before they are all shown would give them away
+    bool lost = result.outcome == Solver::Unsolvable && !m_position.hasHiddenCards();
+    // Engine describes the move, it knows the names of the cards
+    int from = -1, to = -1, count = 0;
+    if (result.outcome == Solver::Solvable && !result.solution.empty()) {
+        const SolverMove &move = result.solution.front();
+        from = m_position.slotIds[move.from];
+        to = m_position.slotIds[move.to];
+        count = move.kind == SolverMove::Transfer ? move.count : 0;
+    }
+    qCDebug(lcSolver) << "Analyzed position" << m_generation << "with outcome" << result.outcome
+                      << "after" << result.nodes << "nodes";
+    QMetaObject::invokeMethod(Engine::instance(), "handlePositionAnalyzed", Qt::QueuedConnection,
+                              Q_ARG(quint32, m_generation), Q_ARG(bool, lost),
+                              Q_ARG(int, from), Q_ARG(int, to), Q_ARG(int, count));
+}
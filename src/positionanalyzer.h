@@ -0,0 +1,45 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POSITIONANALYZER_H
+#define POSITIONANALYZER_H
+
+#include <QRunnable>
+#include <QSharedPointer>
+#include "solver.h"
+
+/*
+ * Searches a copy of the current position in the background to find out
+ * whether the game can still be won and which move to hint. Result is
+ * delivered to Engine with a queued call to handlePositionAnalyzed.
+ */
+class PositionAnalyzer : public QRunnable
+{
+public:
+    PositionAnalyzer(QSharedPointer<Solver> solver, const SolverPosition &position,
+                     quint64 gameKey, quint32 generation);
+
+    void run();
+
+private:
+    QSharedPointer<Solver> m_solver;
+    SolverPosition m_position;
+    quint64 m_gameKey;
+    quint32 m_generation;
+};
+
+#endif // POSITIONANALYZER_H
@@ -0,0 +1,346 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include "constants.h"
+#include "logging.h"
+#include "seeddatabase.h"
+
+namespace {
+
+const char Magic[4] = { 'P', 'D', 'S', 'D' };
+const quint32 Version = 2;
+// Difficulty limits for rating, 2000 and 100000 search nodes
+const quint8 EasyLimit = 88;
+const quint8 HardLimit = 133;
+
+inline qint64 words(quint32 count)
+{
+    return ((qint64)count + 63) / 64;
+}
+
+inline qint64 padded(qint64 size)
+{
+    return (size + 7) & ~7;
+}
+
+SeedDatabase::Record combine(SeedDatabase::Record a, SeedDatabase::Record b)
+{
+    // Order of shards must not matter
+    if (a.classification == SeedDatabase::Unknown && b.classification != SeedDatabase::Unknown)
+        return b;
+    if (b.classification == SeedDatabase::Unknown && a.classification != SeedDatabase::Unknown)
+        return a;
+    if (a.classification != b.classification)
+        return { SeedDatabase::Unknown, 0 };
+    return { a.classification, std::min(a.difficulty, b.difficulty) };
+}
+
+} // namespace
+
+const QString Constants::SeedDirectory = QStringLiteral(QUOTE(DATADIR) "/seeds");
+
+struct SeedDatabase::Header {
+    char magic[4];
+    quint32 version;
+    quint64 options;
+    quint32 firstSeed;
+    quint32 count;
+    quint32 winnableCount;
+    quint32 reserved[3];
+};
+
+SeedDatabase::SeedDatabase(const QString &path)
+    : m_file(path)
+    , m_header(nullptr)
+    , m_solvable(nullptr)
+    , m_unsolvable(nullptr)
+    , m_difficulty(nullptr)
+    , m_winnable(nullptr)
+    , m_easyEnd(0)
+    , m_mediumEnd(0)
+{
+    static_assert(sizeof(Header) == 40, "Seed database header must not have padding");
+
+    if (!m_file.exists())
+        return;
+
+    if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < (qint64)sizeof(Header)) {
+        qCWarning(lcSeeds) << "Can not open seed database" << path;
+        return;
+    }
+
+    const uchar *data = m_file.map(0, m_file.size());
+    if (!data) {
+        qCWarning(lcSeeds) << "Can not map seed database" << path;
+        return;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(data);
+    if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != Version) {
+        qCWarning(lcSeeds) << "Seed database" << path << "has wrong format";
+        return;
+    }
+
+    qint64 bitsetSize = words(header->count) * sizeof(quint64);
+    qint64 size = sizeof(Header) + 2 * bitsetSize + padded(header->count)
+        + (qint64)header->winnableCount * sizeof(quint32);
+    if (size != m_file.size() || header->winnableCount > header->count) {
+        qCWarning(lcSeeds) << "Seed database" << path << "is truncated";
+        return;
+    }
+
+    const uchar *it = data + sizeof(Header);
+    m_solvable = reinterpret_cast<const quint64 *>(it);
+    it += bitsetSize;
+    m_unsolvable = reinterpret_cast<const quint64 *>(it);
+    it += bitsetSize;
+    m_difficulty = it;
+    it += padded(header->count);
+    m_winnable = reinterpret_cast<const quint32 *>(it);
+    m_header = header;
+
+    // Winnable seeds are sorted by difficulty, find where the ratings change
+    const quint32 *end = m_winnable + header->winnableCount;
+    m_easyEnd = std::partition_point(m_winnable, end, [this](quint32 index) {
+        return m_difficulty[index] < EasyLimit;
+    }) - m_winnable;
+    m_mediumEnd = std::partition_point(m_winnable, end, [this](quint32 index) {
+        return m_difficulty[index] < HardLimit;
+    }) - m_winnable;
+
+    qCDebug(lcSeeds) << "Loaded seed database" << path << "with" << header->count << "seeds of which"
+                     << header->winnableCount << "are winnable," << m_easyEnd << "easy and"
+                     << header->winnableCount - m_mediumEnd << "hard";
+}
+
+SeedDatabase::~SeedDatabase()
+{
+}
+
+bool SeedDatabase::isValid() const
+{
+    return m_header;
+}
+
+quint64 SeedDatabase::options() const
+{
+    return m_header ? m_header->options : 0;
+}
+
+quint32 SeedDatabase::firstSeed() const
+{
+    return m_header ? m_header->firstSeed : 0;
+}
+
+quint32 SeedDatabase::count() const
+{
+    return m_header ? m_header->count : 0;
+}
+
+SeedDatabase::Classification SeedDatabase::classification(quint32 seed) const
+{
+    if (!contains(seed))
+        return Unknown;
+    quint32 index = seed - m_header->firstSeed;
+    if (testBit(m_solvable, index))
+        return Solvable;
+    if (testBit(m_unsolvable, index))
+        return Unsolvable;
+    return Unknown;
+}
+
+quint8 SeedDatabase::difficulty(quint32 seed) const
+{
+    return contains(seed) ? m_difficulty[seed - m_header->firstSeed] : 0;
+}
+
+bool SeedDatabase::pick(Filter filter, quint32 random, quint32 *seed) const
+{
+    if (!m_header)
+        return false;
+
+    quint32 first;
+    quint32 last;
+    switch (filter) {
+    case WinnableDeal:
+        first = 0;
+        last = m_header->winnableCount;
+        break;
+    case EasyDeal:
+        first = 0;
+        last = m_easyEnd;
+        break;
+    case MediumDeal:
+        first = m_easyEnd;
+        last = m_mediumEnd;
+        break;
+    case HardDeal:
+        first = m_mediumEnd;
+        last = m_header->winnableCount;
+        break;
+    default:
+        return false;
+    }
+
+    if (first == last)
+        return false;
+    *seed = m_header->firstSeed + m_winnable[first + random % (last - first)];
+    return true;
+}
+
+SeedDatabase::Rating SeedDatabase::rating(quint32 seed) const
+{
+    return rate(classification(seed), difficulty(seed));
+}
+
+SeedDatabase::Rating SeedDatabase::rate(Classification classification, quint8 difficulty)
+{
+    switch (classification) {
+    case Solvable:
+        if (difficulty < EasyLimit)
+            return EasyRating;
+        return difficulty < HardLimit ? MediumRating : HardRating;
+    case Unsolvable:
+        return UnwinnableRating;
+    default:
+        return UnknownRating;
+    }
+}
+
+QString SeedDatabase::path(const QString &gameFile)
+{
+    QString name = QFileInfo(gameFile).completeBaseName();
+    return QStringLiteral("%1/%2.seeds").arg(Constants::SeedDirectory).arg(name);
+}
+
+quint64 SeedDatabase::optionsMask(const GameOptionList &options)
+{
+    quint64 mask = 0;
+    for (const GameOption &option : options) {
+        if (option.set && option.index < 64)
+            mask |= Q_UINT64_C(1) << option.index;
+    }
+    return mask;
+}
+
+quint8 SeedDatabase::quantise(quint64 nodes)
+{
+    // Eight steps per doubling of search nodes
+    return std::min<quint64>(255, std::lround(std::log2(nodes + 1.0) * 8));
+}
+
+bool SeedDatabase::write(const QString &path, quint64 options, quint32 firstSeed,
+                         const QVector<Record> &records)
+{
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.options = options;
+    header.firstSeed = firstSeed;
+    header.count = records.count();
+    memset(header.reserved, 0, sizeof(header.reserved));
+
+    std::vector<quint64> solvable(words(header.count), 0);
+    std::vector<quint64> unsolvable(words(header.count), 0);
+    std::vector<quint8> difficulty(padded(header.count), 0);
+    std::vector<quint32> winnable;
+    for (quint32 i = 0; i < header.count; i++) {
+        const Record &record = records.at(i);
+        difficulty[i] = record.difficulty;
+        if (record.classification == Solvable) {
+            solvable[i / 64] |= Q_UINT64_C(1) << (i % 64);
+            winnable.push_back(i);
+        } else if (record.classification == Unsolvable) {
+            unsolvable[i / 64] |= Q_UINT64_C(1) << (i % 64);
+        }
+    }
+
+    // Stable sort keeps the file identical for identical results
+    std::stable_sort(winnable.begin(), winnable.end(), [&difficulty](quint32 a, quint32 b) {
+        return difficulty[a] < difficulty[b];
+    });
+    header.winnableCount = winnable.size();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcSeeds) << "Can not write seed database" << path;
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(solvable.data()), solvable.size() * sizeof(quint64));
+    file.write(reinterpret_cast<const char *>(unsolvable.data()), unsolvable.size() * sizeof(quint64));
+    file.write(reinterpret_cast<const char *>(difficulty.data()), difficulty.size());
+    file.write(reinterpret_cast<const char *>(winnable.data()), winnable.size() * sizeof(quint32));
+    return file.commit();
+}
+
+bool SeedDatabase::merge(const QString &path, const QStringList &inputs)
+{
+    std::vector<std::unique_ptr<SeedDatabase>> shards;
+    quint64 first = std::numeric_limits<quint64>::max();
+    quint64 end = 0;
+    for (const QString &input : inputs) {
+        std::unique_ptr<SeedDatabase> shard(new SeedDatabase(input));
+        if (!shard->isValid()) {
+            qCWarning(lcSeeds) << "Can not merge invalid seed database" << input;
+            return false;
+        }
+        if (!shards.empty() && shard->options() != shards.front()->options()) {
+            qCWarning(lcSeeds) << "Can not merge seed databases with different options";
+            return false;
+        }
+        first = std::min<quint64>(first, shard->firstSeed());
+        end = std::max<quint64>(end, (quint64)shard->firstSeed() + shard->count());
+        shards.push_back(std::move(shard));
+    }
+
+    if (shards.empty() || end - first > std::numeric_limits<quint32>::max())
+        return false;
+
+    // Seeds that are not in any shard stay unknown
+    QVector<Record> records(end - first, { Unknown, 0 });
+    QVector<bool> seen(end - first, false);
+    for (const auto &shard : shards) {
+        for (quint32 i = 0; i < shard->count(); i++) {
+            quint32 seed = shard->firstSeed() + i;
+            quint32 index = seed - first;
+            Record record = { shard->classification(seed), shard->difficulty(seed) };
+            records[index] = seen[index] ? combine(records[index], record) : record;
+            seen[index] = true;
+        }
+    }
+
+    return write(path, shards.front()->options(), first, records);
+}
+
+bool SeedDatabase::contains(quint32 seed) const
+{
+    return m_header && seed >= m_header->firstSeed
+        && (quint64)seed < (quint64)m_header->firstSeed + m_header->count;
+}
+
+bool SeedDatabase::testBit(const quint64 *bits, quint32 index) const
+{
+    return bits[index / 64] & (Q_UINT64_C(1) << (index % 64));
+}
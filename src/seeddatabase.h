@@ -0,0 +1,100 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEEDDATABASE_H
+#define SEEDDATABASE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "enginedata.h"
+
+/*
+ * Pre-computed classification of seeds for one game.
+ *
+ * The file is memory mapped and consists of a header, bitsets for
+ * solvable and unsolvable seeds, one byte of difficulty per seed and
+ * a list of winnable seeds sorted by difficulty for constant time
+ * picking.
+ */
+class SeedDatabase
+{
+public:
+    enum Classification : quint8 {
+        Unknown,
+        Solvable,
+        Unsolvable,
+    };
+
+    enum Filter {
+        AnyDeal,
+        WinnableDeal,
+        EasyDeal,
+        MediumDeal,
+        HardDeal,
+    };
+
+    enum Rating {
+        UnknownRating,
+        EasyRating,
+        MediumRating,
+        HardRating,
+        UnwinnableRating,
+    };
+
+    struct Record {
+        Classification classification;
+        quint8 difficulty;
+    };
+
+    explicit SeedDatabase(const QString &path);
+    ~SeedDatabase();
+
+    bool isValid() const;
+    quint64 options() const;
+    quint32 firstSeed() const;
+    quint32 count() const;
+    Classification classification(quint32 seed) const;
+    quint8 difficulty(quint32 seed) const;
+    bool pick(Filter filter, quint32 random, quint32 *seed) const;
+    Rating rating(quint32 seed) const;
+
+    static QString path(const QString &gameFile);
+    static quint64 optionsMask(const GameOptionList &options);
+    static quint8 quantise(quint64 nodes);
+    static Rating rate(Classification classification, quint8 difficulty);
+    static bool write(const QString &path, quint64 options, quint32 firstSeed,
+                      const QVector<Record> &records);
+    static bool merge(const QString &path, const QStringList &inputs);
+
+private:
+    struct Header;
+
+    bool contains(quint32 seed) const;
+    bool testBit(const quint64 *bits, quint32 index) const;
+
+    QFile m_file;
+    const Header *m_header;
+    const quint64 *m_solvable;
+    const quint64 *m_unsolvable;
+    const quint8 *m_difficulty;
+    const quint32 *m_winnable;
+    quint32 m_easyEnd;
+    quint32 m_mediumEnd;
+};
+
+#endif // SEEDDATABASE_H
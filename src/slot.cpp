@@ -46,6 +46,11 @@ Slot::Slot(int id, SlotType type, double x, double y, int expansionDepth,
 {
 }
 
+Slot::~Slot()
+{
+    qDeleteAll(m_cards);
+}
+
 void Slot::updateDimensions()
 {
     QSizeF margin = m_table->margin();
@@ -57,8 +62,6 @@ void Slot::updateDimensions()
     QSizeF cardSize = m_table->cardSize();
     setWidth(cardSize.width());
     setHeight(cardSize.height());
-    for (Card *card : m_cards)
-        card->setSize(cardSize);
 
     updateLocations();
 }
@@ -75,17 +78,13 @@ void Slot::updateLocations(iterator first)
 
     for (auto it = first; it != end(); it++) {
         Card *card = *it;
-        card->setZ(it - begin());
-        if (expandedRight()) {
-            card->setX(round(delta(it)));
-            card->setY(0);
-        } else if (expandedDown()) {
-            card->setX(0);
-            card->setY(round(delta(it)));
-        } else {
-            card->setX(0);
-            card->setY(0);
-        }
+        // Cards are drawn in the order they are in the slot
+        if (expandedRight())
+            card->setPosition(QPointF(round(delta(it)), 0));
+        else if (expandedDown())
+            card->setPosition(QPointF(0, round(delta(it))));
+        else
+            card->setPosition(QPointF(0, 0));
     }
 }
 
@@ -94,6 +93,11 @@ int Slot::id() const
     return m_id;
 }
 
+SlotType Slot::type() const
+{
+    return m_type;
+}
+
 QPointF Slot::position() const
 {
     return m_position;
@@ -118,10 +122,8 @@ void Slot::append(Card *card)
 {
     card->setParentItem(this);
     m_cards.append(card);
-    // TODO: Do adjustments once move ends
-    if (!m_table->preparing()) {
-        updateLocations(expanded() ? firstExpanded() : end()-1);
-    }
+    if (!m_table->preparing())
+        m_table->relayout(this);
     qCDebug(lcSlot) << "Added card to slot" << m_id << "and card count is now" << m_cards.count();
 }
 
@@ -130,10 +132,8 @@ void Slot::insert(int index, Card *card)
     card->setParentItem(this);
     auto it = m_cards.begin() + index;
     m_cards.insert(it, card);
-    // TODO: Do adjustments once move ends
-    if (!m_table->preparing()) {
-        updateLocations();
-    }
+    if (!m_table->preparing())
+        m_table->relayout(this);
     qCDebug(lcSlot) << "Inserted card to slot" << m_id << "and card count is now" << m_cards.count();
 }
 
@@ -141,7 +141,7 @@ Card *Slot::takeAt(int index)
 {
     Card *card = m_cards.takeAt(index);
     if (!m_table->preparing())
-        updateLocations();
+        m_table->relayout(this);
     qCDebug(lcSlot) << "Removed card from slot" << m_id << "and card count is now" << m_cards.count();
     if (isEmpty())
         emit slotEmptied();
@@ -160,16 +160,12 @@ QList<Card *> Slot::takeAll()
 void Slot::highlight()
 {
     m_highlighted = true;
-    if (!isEmpty())
-        top()->update();
     qCDebug(lcSlot) << "Slot" << m_id << "is now highlighted";
 }
 
 void Slot::removeHighlight()
 {
     m_highlighted = false;
-    if (!isEmpty())
-        top()->update();
     qCDebug(lcSlot) << "Slot" << m_id << "is no longer highlighted";
 }
 
@@ -188,7 +184,7 @@ QList<Card *> Slot::take(Card *first)
     QList<Card *> tail = m_cards.mid(m_cards.indexOf(first));
     m_cards.erase(find(first), end());
     if (expanded() && !m_table->preparing())
-        updateLocations();
+        m_table->relayout(this);
     qCDebug(lcSlot) << "Removed" << tail.count() << "cards from slot" << m_id
                     << "and card count is now" << m_cards.count();
     return tail;
@@ -200,7 +196,7 @@ void Slot::put(const QList<Card *> &cards)
     for (Card *card : cards)
         card->setParentItem(this);
     if (!m_table->preparing())
-        updateLocations();
+        m_table->relayout(this);
     qCDebug(lcSlot) << "Added" << cards.count() << "cards to slot" << m_id
                     << "and card count is now" << m_cards.count();
 }
@@ -215,6 +211,23 @@ bool Slot::contains(Card *card) const
     return m_cards.contains(card);
 }
 
+QRectF Slot::cardsRect() const
+{
+    QRectF rect;
+    for (Card *card : m_cards)
+        rect |= card->mapRectToItem(this, card->boundingRect());
+    return rect;
+}
+
+Card *Slot::cardAt(const QPointF &point) const
+{
+    for (auto it = constEnd(); it-- != constBegin();) {
+        if ((*it)->mapRectToItem(this, (*it)->boundingRect()).contains(point))
+            return *it;
+    }
+    return nullptr;
+}
+
 bool Slot::expanded() const
 {
     return m_expansion != DoesNotExpand;
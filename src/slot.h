@@ -53,12 +53,14 @@ public:
 
     Slot(int id, SlotType type, double x, double y, int expansionDepth,
          bool expandedDown, bool expandedRight, Table *table);
+    ~Slot();
 
     void updateDimensions();
     void updateLocations();
     void updateLocations(iterator iter);
 
     int id() const;
+    SlotType type() const;
     QPointF position() const;
     int count() const;
     bool isEmpty() const;
@@ -77,6 +79,8 @@ public:
     Card *top() const;
     bool contains(Card *card) const;
     using QQuickItem::contains;
+    QRectF cardsRect() const;
+    Card *cardAt(const QPointF &point) const;
 
     bool expanded() const;
     bool expandedRight() const;
@@ -0,0 +1,528 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <random>
+#include "klondikesolver.h"
+#include "logging.h"
+#include "solver.h"
+#include "spidersolver.h"
+
+namespace {
+
+const int MaxDepth = 1000;
+const int JobsPerThread = 4;
+const int MaxFrontierDepth = 4;
+const quint64 DefaultNodeLimit = 2000000;
+const qint64 DefaultTimeLimit = 5000;
+// Between 512 KiB and 32 MiB of transposition table
+const int MinTableBits = 16;
+const int MaxTableBits = 22;
+
+quint64 mix(quint64 value)
+{
+    // splitmix64 finalizer
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+quint64 hashPile(const SolverPile &pile)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (quint8 card : pile) {
+        hash ^= card;
+        hash *= 0x100000001b3ULL;
+    }
+    return mix(hash ^ pile.size());
+}
+
+QString gameName(const QString &gameFile)
+{
+    QString name = gameFile.mid(gameFile.lastIndexOf('/') + 1);
+    if (name.endsWith(QStringLiteral(".scm")))
+        name.chop(4);
+    return name;
+}
+
+} // namespace
+
+bool SolverPosition::fromSlots(const QHash<int, CardList> &slots,
+                               const QHash<int, SlotType> &types,
+                               SolverPosition *position)
+{
+    QList<int> ids = slots.keys();
+    std::sort(ids.begin(), ids.end());
+
+    position->piles.clear();
+    position->types.clear();
+    position->slotIds.clear();
+    position->redealsLeft = -1;
+    position->orderedTableau = false;
+    for (int id : ids) {
+        SolverPile pile;
+        for (const CardData &card : slots[id]) {
+            if (card.rank < RankAce || card.rank > RankKing)
+                return false;
+            pile.push_back(SolverCard::make(card.suit, card.rank, card.show));
+        }
+        position->piles.push_back(pile);
+        position->types.push_back(types.value(id, UnknownSlot));
+        position->slotIds.push_back(id);
+    }
+    return true;
+}
+
+int SolverPosition::pileForSlot(int slotId) const
+{
+    for (size_t i = 0; i < slotIds.size(); i++) {
+        if (slotIds[i] == slotId)
+            return i;
+    }
+    return -1;
+}
+
+quint64 SolverPosition::hash() const
+{
+    // Tableau and foundation piles are interchangeable, so they are hashed
+    // independent of their order, unless there are cards left to deal to
+    // the tableau by pile
+    bool ordered = false;
+    if (orderedTableau) {
+        for (size_t i = 0; i < piles.size() && !ordered; i++)
+            ordered = types[i] == StockSlot && !piles[i].empty();
+    }
+
+    std::vector<quint64> tableau;
+    std::vector<quint64> foundations;
+    quint64 hash = mix(redealsLeft + 2);
+    for (size_t i = 0; i < piles.size(); i++) {
+        quint64 pileHash = hashPile(piles[i]);
+        if (types[i] == TableauSlot)
+            tableau.push_back(pileHash);
+        else if (types[i] == FoundationSlot)
+            foundations.push_back(pileHash);
+        else
+            hash = mix(hash ^ pileHash);
+    }
+    if (!ordered)
+        std::sort(tableau.begin(), tableau.end());
+    std::sort(foundations.begin(), foundations.end());
+    for (quint64 pileHash : tableau)
+        hash = mix(hash ^ pileHash);
+    hash = mix(hash ^ 0x7461626c65617500ULL);
+    for (quint64 pileHash : foundations)
+        hash = mix(hash ^ pileHash);
+    return hash;
+}
+
+int SolverPosition::count(SlotType type) const
+{
+    return std::count(types.begin(), types.end(), type);
+}
+
+bool SolverPosition::hasHiddenCards() const
+{
+    for (const SolverPile &pile : piles) {
+        for (quint8 card : pile) {
+            if (!SolverCard::faceUp(card))
+                return true;
+        }
+    }
+    return false;
+}
+
+TranspositionTable::TranspositionTable(int bits)
+    : m_table(new std::atomic<quint64>[1ULL << bits])
+    , m_mask((1ULL << bits) - 1)
+    , m_overflows(0)
+{
+    clear();
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    delete[] m_table;
+}
+
+bool TranspositionTable::insert(quint64 hash)
+{
+    // Lock free linear probing, zero marks an empty entry
+    if (hash == 0)
+        hash = 1;
+    for (quint64 i = 0; i < 16; i++) {
+        std::atomic<quint64> &entry = m_table[(hash + i) & m_mask];
+        quint64 current = entry.load(std::memory_order_relaxed);
+        if (current == hash)
+            return false;
+        if (current == 0) {
+            if (entry.compare_exchange_strong(current, hash))
+                return true;
+            if (current == hash)
+                return false;
+        }
+    }
+    // Table is too full here, treat as a new position
+    m_overflows.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TranspositionTable::clear()
+{
+    for (quint64 i = 0; i <= m_mask; i++)
+        m_table[i].store(0, std::memory_order_relaxed);
+    m_overflows.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::reserve(quint64 count)
+{
+    // Keep the table at most half full to keep probing short
+    int bits = MinTableBits;
+    while (bits < MaxTableBits && (1ULL << (bits - 1)) < count)
+        bits++;
+    if ((1ULL << bits) - 1 <= m_mask)
+        return;
+
+    delete[] m_table;
+    m_table = new std::atomic<quint64>[1ULL << bits];
+    m_mask = (1ULL << bits) - 1;
+    clear();
+}
+
+quint64 TranspositionTable::overflows() const
+{
+    return m_overflows.load(std::memory_order_relaxed);
+}
+
+Solver::Limits::Limits()
+    : nodes(DefaultNodeLimit)
+    , msecs(DefaultTimeLimit)
+    , threads(QThread::idealThreadCount())
+{
+}
+
+Solver::Result::Result()
+    : outcome(Unknown)
+    , nodes(0)
+    , deadEnds(0)
+    , depth(0)
+    , msecs(0)
+{
+}
+
+struct Solver::Search
+{
+    enum Status {
+        Pending,
+        Dead,
+        Won,
+        Aborted,
+    };
+
+    struct Job {
+        SolverPosition position;
+        std::vector<SolverMove> path;
+        Status status;
+        quint64 nodes;
+        quint64 deadEnds;
+        bool budgetHit;
+    };
+
+    struct Worker : public QRunnable {
+        Worker(Search *search) : m_search(search) {}
+        void run() { m_search->work(); }
+        Search *m_search;
+    };
+
+    Search(Solver *solver, const Limits &limits)
+        : solver(solver)
+        , limits(limits)
+        , next(0)
+        , nodes(0)
+        , stop(false)
+    {
+        timer.start();
+    }
+
+    bool outOfTime() const
+    {
+        return limits.msecs > 0 && timer.hasExpired(limits.msecs);
+    }
+
+    Status dfs(SolverPosition &position, Job &job, int depth)
+    {
+        if (stop.load(std::memory_order_relaxed) || solver->m_canceled.load())
+            return Aborted;
+
+        job.nodes++;
+        quint64 count = nodes.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (count > limits.nodes || ((job.nodes & 0x3ff) == 0 && outOfTime())) {
+            job.budgetHit = true;
+            return Aborted;
+        }
+
+        if (solver->isWon(position))
+            return Won;
+
+        if (depth >= MaxDepth) {
+            job.budgetHit = true;
+            return Aborted;
+        }
+
+        if (!solver->m_table.insert(position.hash()))
+            return Dead;
+
+        std::vector<SolverMove> moves;
+        solver->moves(position, moves);
+        if (moves.empty()) {
+            job.deadEnds++;
+            return Dead;
+        }
+
+        for (const SolverMove &move : moves) {
+            SolverPosition child(position);
+            solver->apply(child, move);
+            job.path.push_back(move);
+            Status status = dfs(child, job, depth + 1);
+            if (status != Dead)
+                return status;
+            job.path.pop_back();
+        }
+        return Dead;
+    }
+
+    void work()
+    {
+        int index;
+        while ((index = next.fetch_add(1)) < (int)jobs.size()) {
+            Job &job = jobs[index];
+            if (job.status != Pending)
+                continue;
+            if (stop.load())
+                break;
+            job.status = dfs(job.position, job, job.path.size());
+            if (job.status == Won)
+                stop.store(true);
+        }
+    }
+
+    void run(int threads)
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(std::max(threads, 1));
+        for (int i = 0; i < pool.maxThreadCount(); i++)
+            pool.start(new Worker(this));
+        pool.waitForDone();
+    }
+
+    Solver *solver;
+    Limits limits;
+    QElapsedTimer timer;
+    std::vector<Job> jobs;
+    std::atomic<int> next;
+    std::atomic<quint64> nodes;
+    std::atomic<bool> stop;
+};
+
+Solver *Solver::create(const QString &gameFile, const GameOptionList &options)
+{
+    QString name = gameName(gameFile);
+    if (KlondikeSolver::supports(name))
+        return new KlondikeSolver(name, options);
+    if (SpiderSolver::supports(name))
+        return new SpiderSolver(name);
+    return nullptr;
+}
+
+bool Solver::isSupported(const QString &gameFile)
+{
+    QString name = gameName(gameFile);
+    return KlondikeSolver::supports(name) || SpiderSolver::supports(name);
+}
+
+Solver::Solver()
+    : m_canceled(0)
+    , m_table(MinTableBits)
+{
+}
+
+Solver::~Solver()
+{
+}
+
+Solver::Result Solver::solve(const SolverPosition &position, const Limits &limits)
+{
+    SolverPosition prepared(position);
+    prepare(prepared);
+    Result result = solvePrepared(prepared, limits);
+
+    qCDebug(lcSolver) << "Solved with outcome" << result.outcome << "after" << result.nodes
+                      << "nodes in" << result.msecs << "ms";
+    return result;
+}
+
+Solver::Result Solver::solvePrepared(const SolverPosition &position, const Limits &limits)
+{
+    m_table.reserve(limits.nodes);
+    m_table.clear();
+
+    Search search(this, limits);
+    Result result;
+
+    // Expand the beginning of the search tree until there is enough work
+    // for all threads, these jobs are then searched depth first
+    Search::Job root = { position, {}, Search::Pending, 0, 0, false };
+    std::vector<Search::Job> frontier(1, root);
+    int wanted = std::max(limits.threads, 1) * JobsPerThread;
+    for (int depth = 0; depth < MaxFrontierDepth && (int)frontier.size() < wanted; depth++) {
+        std::vector<Search::Job> expanded;
+        for (Search::Job &job : frontier) {
+            result.nodes++;
+            if (isWon(job.position)) {
+                result.outcome = Solvable;
+                result.depth = job.path.size();
+                result.solution = job.path;
+                result.msecs = search.timer.elapsed();
+                return result;
+            }
+            std::vector<SolverMove> moves;
+            this->moves(job.position, moves);
+            if (moves.empty())
+                result.deadEnds++;
+            for (const SolverMove &move : moves) {
+                Search::Job child(job);
+                apply(child.position, move);
+                child.path.push_back(move);
+                expanded.push_back(child);
+            }
+        }
+        if (expanded.empty()) {
+            result.outcome = Unsolvable;
+            result.msecs = search.timer.elapsed();
+            return result;
+        }
+        frontier.swap(expanded);
+    }
+
+    search.jobs.swap(frontier);
+    search.run(limits.threads);
+
+    bool budgetHit = false;
+    for (const Search::Job &job : search.jobs) {
+        result.nodes += job.nodes;
+        result.deadEnds += job.deadEnds;
+        budgetHit |= job.budgetHit || job.status == Search::Aborted || job.status == Search::Pending;
+        if (job.status == Search::Won && result.outcome != Solvable) {
+            result.outcome = Solvable;
+            result.solution = job.path;
+            result.depth = job.path.size();
+        }
+    }
+    if (result.outcome != Solvable && !budgetHit && !m_canceled.load())
+        result.outcome = Unsolvable;
+    result.msecs = search.timer.elapsed();
+
+    if (m_table.overflows() > 0) {
+        qCWarning(lcSolver) << "Transposition table was saturated" << m_table.overflows()
+                            << "times, positions were searched again";
+    }
+    return result;
+}
+
+Solver::Estimate Solver::estimate(const SolverPosition &position, int samples,
+                                  const Limits &limits, quint32 seed)
+{
+    QElapsedTimer timer;
+    timer.start();
+    Estimate estimate = { 0.0, samples, 0, 0, 0 };
+
+    // Cards facing down are unknown to the player, shuffle them between
+    // their places for every sample and solve the result thoughtfully
+    std::vector<std::pair<int, int>> hidden;
+    std::vector<quint8> cards;
+    for (size_t i = 0; i < position.piles.size(); i++) {
+        for (size_t j = 0; j < position.piles[i].size(); j++) {
+            if (!SolverCard::faceUp(position.piles[i][j])) {
+                hidden.push_back(std::make_pair(i, j));
+                cards.push_back(position.piles[i][j]);
+            }
+        }
+    }
+
+    // Samples are solved one after another with all threads, so that each
+    // of them starts with an empty transposition table
+    std::mt19937 generator(seed);
+    int dead = 0;
+    for (int i = 0; i < samples && !m_canceled.load(); i++) {
+        Limits sampleLimits(limits);
+        if (limits.msecs > 0) {
+            // Share the remaining time evenly between the remaining samples
+            sampleLimits.msecs = (limits.msecs - timer.elapsed()) / (samples - i);
+            if (sampleLimits.msecs <= 0)
+                break;
+        }
+
+        SolverPosition sample(position);
+        std::shuffle(cards.begin(), cards.end(), generator);
+        for (size_t j = 0; j < hidden.size(); j++)
+            sample.piles[hidden[j].first][hidden[j].second] = cards[j];
+        prepare(sample);
+
+        Result result = solvePrepared(sample, sampleLimits);
+        estimate.nodes += result.nodes;
+        if (result.outcome == Solvable)
+            estimate.solved++;
+        else if (result.outcome == Unsolvable)
+            dead++;
+    }
+    estimate.unknown = samples - estimate.solved - dead;
+    if (samples > 0)
+        estimate.probability = (qreal)estimate.solved / samples;
+
+    qCDebug(lcSolver) << "Estimated winning probability of" << estimate.probability
+                      << "from" << samples << "samples," << estimate.unknown << "unknown";
+    return estimate;
+}
+
+void Solver::cancel()
+{
+    m_canceled.store(1);
+}
+
+bool Solver::isCanceled() const
+{
+    return m_canceled.load();
+}
+
+void Solver::prepare(SolverPosition &position) const
+{
+    Q_UNUSED(position)
+}
+
+void Solver::flipTop(SolverPile &pile)
+{
+    if (!pile.empty())
+        pile.back() |= SolverCard::FaceUp;
+}
@@ -0,0 +1,190 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QString>
+#include <atomic>
+#include <vector>
+#include "enginedata.h"
+
+namespace SolverCard {
+
+// Cards are packed to one byte: rank in bits 0-3, suit in bits 4-5
+// and bit 6 tells whether the card is facing up
+const quint8 RankMask = 0x0f;
+const quint8 FaceUp = 0x40;
+
+inline quint8 make(Suit suit, Rank rank, bool show)
+{
+    return (rank & RankMask) | (suit << 4) | (show ? FaceUp : 0);
+}
+
+inline int rank(quint8 card)
+{
+    return card & RankMask;
+}
+
+inline int suit(quint8 card)
+{
+    return (card >> 4) & 0x03;
+}
+
+inline bool faceUp(quint8 card)
+{
+    return card & FaceUp;
+}
+
+inline bool isRed(quint8 card)
+{
+    return suit(card) == SuitDiamonds || suit(card) == SuitHeart;
+}
+
+inline bool sameSuit(quint8 card, quint8 other)
+{
+    return suit(card) == suit(other);
+}
+
+} // SolverCard
+
+typedef std::vector<quint8> SolverPile;
+
+struct SolverMove {
+    enum Kind : quint8 {
+        Transfer,
+        Deal,
+        Redeal,
+    };
+
+    Kind kind;
+    quint8 from;
+    quint8 to;
+    quint8 count;
+};
+
+struct SolverPosition {
+    std::vector<SolverPile> piles;
+    std::vector<SlotType> types;
+    std::vector<int> slotIds;
+    int redealsLeft;
+    // Dealing from the stock to the tableau tells the piles apart
+    bool orderedTableau;
+
+    static bool fromSlots(const QHash<int, CardList> &slots,
+                          const QHash<int, SlotType> &types,
+                          SolverPosition *position);
+    int pileForSlot(int slotId) const;
+    quint64 hash() const;
+    int count(SlotType type) const;
+    bool hasHiddenCards() const;
+};
+
+class TranspositionTable
+{
+public:
+    explicit TranspositionTable(int bits = 22);
+    ~TranspositionTable();
+
+    bool insert(quint64 hash);
+    void clear();
+    // Grows the table to hold the given number of positions comfortably
+    void reserve(quint64 count);
+    // Positions that did not fit since the last clear
+    quint64 overflows() const;
+
+private:
+    std::atomic<quint64> *m_table;
+    quint64 m_mask;
+    std::atomic<quint64> m_overflows;
+};
+
+class Solver
+{
+public:
+    enum Outcome {
+        Unknown,
+        Solvable,
+        Unsolvable,
+    };
+
+    struct Limits {
+        quint64 nodes;
+        qint64 msecs;
+        int threads;
+
+        Limits();
+    };
+
+    struct Result {
+        Outcome outcome;
+        quint64 nodes;
+        quint64 deadEnds;
+        int depth;
+        qint64 msecs;
+        std::vector<SolverMove> solution;
+
+        Result();
+    };
+
+    struct Estimate {
+        qreal probability;
+        int samples;
+        int solved;
+        int unknown;
+        quint64 nodes;
+    };
+
+    static Solver *create(const QString &gameFile, const GameOptionList &options);
+    static bool isSupported(const QString &gameFile);
+
+    virtual ~Solver();
+
+    // Thoughtful solving where face down cards are known to the solver
+    Result solve(const SolverPosition &position, const Limits &limits);
+    // Estimates winning chances by shuffling cards that are not shown,
+    // only used by the tools as the game does not show the chances
+    Estimate estimate(const SolverPosition &position, int samples,
+                      const Limits &limits, quint32 seed);
+    // Canceling is permanent, searches return immediately after it, so
+    // every request that may be canceled needs a solver of its own
+    void cancel();
+    bool isCanceled() const;
+
+    virtual void moves(const SolverPosition &position, std::vector<SolverMove> &moves) const = 0;
+    virtual void apply(SolverPosition &position, const SolverMove &move) const = 0;
+    virtual bool isWon(const SolverPosition &position) const = 0;
+
+protected:
+    Solver();
+
+    virtual void prepare(SolverPosition &position) const;
+    static void flipTop(SolverPile &pile);
+
+private:
+    struct Search;
+    friend struct Search;
+
+    Result solvePrepared(const SolverPosition &position, const Limits &limits);
+
+    QAtomicInt m_canceled;
+    TranspositionTable m_table;
+};
+
+#endif // SOLVER_H
@@ -0,0 +1,244 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <cstring>
+#include "logging.h"
+#include "seeddatabase.h"
+#include "solvercache.h"
+
+namespace {
+
+const char Magic[4] = { 'P', 'D', 'S', 'C' };
+const quint32 Version = 2;
+// 2 MiB of entries in sets of eight
+const quint32 EntryCount = 65536;
+const quint32 SetSize = 8;
+
+inline quint64 mix(quint64 value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+} // namespace
+
+Q_GLOBAL_STATIC(SolverCache, cacheInstance)
+
+struct SolverCache::Header {
+    char magic[4];
+    quint32 version;
+    quint32 count;
+    quint32 clock;
+};
+
+struct SolverCache::Entry {
+    quint64 game;
+    quint64 position;
+    // Not covered by checksum, updated on every hit
+    quint32 stamp;
+    quint32 checksum;
+    quint8 outcome;
+    quint8 difficulty;
+    quint8 hasMove;
+    quint8 reserved;
+    SolverMove move;
+};
+
+SolverCache *SolverCache::instance()
+{
+    return cacheInstance();
+}
+
+quint64 SolverCache::gameKey(const QString &gameFile, const GameOptionList &options)
+{
+    // qHash is salted per process, this must stay the same across runs
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (char c : QFileInfo(gameFile).completeBaseName().toUtf8()) {
+        hash ^= (quint8)c;
+        hash *= 0x100000001b3ULL;
+    }
+    return mix(hash ^ mix(SeedDatabase::optionsMask(options)));
+}
+
+quint64 SolverCache::positionKey(const SolverPosition &position)
+{
+    // Unlike SolverPosition::hash this depends on the order of the piles
+    // as cached moves refer to them by index
+    quint64 hash = mix(position.redealsLeft + 2);
+    for (size_t i = 0; i < position.piles.size(); i++) {
+        hash = mix(hash ^ (quint64)position.slotIds[i]);
+        for (quint8 card : position.piles[i]) {
+            hash ^= card;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return mix(hash);
+}
+
+SolverCache::SolverCache()
+    : m_header(nullptr)
+    , m_entries(nullptr)
+{
+    static_assert(sizeof(Header) == 16, "Solver cache header must not have padding");
+    static_assert(sizeof(Entry) == 32, "Solver cache entry must not have padding");
+
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (directory.isEmpty() || !QDir().mkpath(directory)) {
+        qCWarning(lcSolver) << "No cache directory for solver cache";
+        return;
+    }
+
+    QString path = directory + QStringLiteral("/solver.cache");
+    if (!open(path)) {
+        // Start over if the file is corrupt
+        m_file.close();
+        if (!m_file.remove() || !open(path))
+            qCWarning(lcSolver) << "Can not use solver cache" << path;
+    }
+}
+
+SolverCache::~SolverCache()
+{
+}
+
+bool SolverCache::open(const QString &path)
+{
+    qint64 size = sizeof(Header) + (qint64)EntryCount * sizeof(Entry);
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite))
+        return false;
+
+    bool created = m_file.size() == 0;
+    if (created && !m_file.resize(size))
+        return false;
+    if (m_file.size() != size)
+        return false;
+
+    uchar *data = m_file.map(0, size);
+    if (!data)
+        return false;
+
+    Header *header = reinterpret_cast<Header *>(data);
+    if (created) {
+        memcpy(header->magic, Magic, sizeof(Magic));
+        header->version = Version;
+        header->count = EntryCount;
+        header->clock = 0;
+    } else if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != Version
+            || header->count != EntryCount) {
+        m_file.unmap(data);
+        return false;
+    }
+
+    m_header = header;
+    m_entries = reinterpret_cast<Entry *>(data + sizeof(Header));
+    qCDebug(lcSolver) << "Opened solver cache" << path;
+    return true;
+}
+
+bool SolverCache::isValid() const
+{
+    return m_header;
+}
+
+bool SolverCache::lookup(quint64 game, quint64 position, Record *record)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_header)
+        return false;
+
+    Entry *entries = set(game, position);
+    for (quint32 i = 0; i < SetSize; i++) {
+        Entry &entry = entries[i];
+        if (entry.game == game && entry.position == position && entry.checksum == checksum(entry)) {
+            entry.stamp = tick();
+            record->outcome = (Solver::Outcome)entry.outcome;
+            record->difficulty = entry.difficulty;
+            record->hasMove = entry.hasMove;
+            record->move = entry.move;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SolverCache::insert(quint64 game, quint64 position, const Solver::Result &result)
+{
+    // Timeouts depend on the device and the limits, they are not worth keeping
+    if (result.outcome == Solver::Unknown)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_header)
+        return;
+
+    Entry *entries = set(game, position);
+    Entry *victim = &entries[0];
+    for (quint32 i = 0; i < SetSize; i++) {
+        Entry &entry = entries[i];
+        bool valid = entry.checksum == checksum(entry);
+        if (!valid || (entry.game == game && entry.position == position)) {
+            victim = &entry;
+            break;
+        }
+        if (entry.stamp < victim->stamp)
+            victim = &entry;
+    }
+
+    Entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.game = game;
+    entry.position = position;
+    entry.stamp = tick();
+    entry.outcome = result.outcome;
+    entry.difficulty = SeedDatabase::quantise(result.nodes);
+    entry.hasMove = !result.solution.empty();
+    if (entry.hasMove)
+        entry.move = result.solution.front();
+    entry.checksum = checksum(entry);
+    *victim = entry;
+}
+
+quint32 SolverCache::checksum(const Entry &entry)
+{
+    quint64 hash = mix(entry.game ^ 0x736f6c7665720000ULL) ^ entry.position;
+    hash = mix(hash ^ ((quint64)entry.outcome << 32) ^ ((quint64)entry.difficulty << 40)
+               ^ ((quint64)entry.hasMove << 48));
+    hash = mix(hash ^ entry.move.kind ^ (entry.move.from << 8) ^ (entry.move.to << 16)
+               ^ ((quint32)entry.move.count << 24));
+    // Zeroed entries must never be valid
+    return (quint32)hash | 1;
+}
+
+SolverCache::Entry *SolverCache::set(quint64 game, quint64 position) const
+{
+    quint64 index = mix(game ^ position) % (EntryCount / SetSize);
+    return m_entries + index * SetSize;
+}
+
+quint32 SolverCache::tick()
+{
+    return ++m_header->clock;
+}
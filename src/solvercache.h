@@ -0,0 +1,70 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOLVERCACHE_H
+#define SOLVERCACHE_H
+
+#include <QFile>
+#include <QMutex>
+#include "solver.h"
+
+/*
+ * Persistent cache of solver outcomes shared by all games.
+ *
+ * The file is memory mapped and holds a fixed number of entries in
+ * small sets. Each entry is checksummed, so an entry that was being
+ * written when the application died is simply ignored. When a set is
+ * full the least recently used entry in it is replaced.
+ */
+class SolverCache
+{
+public:
+    struct Record {
+        Solver::Outcome outcome;
+        quint8 difficulty;
+        bool hasMove;
+        SolverMove move;
+    };
+
+    static SolverCache *instance();
+
+    static quint64 gameKey(const QString &gameFile, const GameOptionList &options);
+    static quint64 positionKey(const SolverPosition &position);
+
+    SolverCache();
+    ~SolverCache();
+
+    bool isValid() const;
+    bool lookup(quint64 game, quint64 position, Record *record);
+    void insert(quint64 game, quint64 position, const Solver::Result &result);
+
+private:
+    struct Header;
+    struct Entry;
+
+    static quint32 checksum(const Entry &entry);
+    bool open(const QString &path);
+    Entry *set(quint64 game, quint64 position) const;
+    quint32 tick();
+
+    QMutex m_mutex;
+    QFile m_file;
+    Header *m_header;
+    Entry *m_entries;
+};
+
+#endif // SOLVERCACHE_H
@@ -0,0 +1,203 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spidersolver.h"
+#include "logging.h"
+
+using namespace SolverCard;
+
+namespace {
+
+const size_t SuitLength = 13;
+
+} // namespace
+
+SpiderSolver::SpiderSolver(const QString &name)
+    : m_scorpion(name == QStringLiteral("scorpion"))
+{
+    qCDebug(lcSolver) << "Created solver for" << name;
+}
+
+bool SpiderSolver::supports(const QString &name)
+{
+    return name == QStringLiteral("spider")
+        || name == QStringLiteral("spiderette")
+        || name == QStringLiteral("scorpion");
+}
+
+void SpiderSolver::moves(const SolverPosition &position, std::vector<SolverMove> &moves) const
+{
+    int stock = -1;
+    int emptyTableau = -1;
+    std::vector<int> tableau;
+    bool canDeal = false;
+    for (size_t i = 0; i < position.types.size(); i++) {
+        if (position.types[i] == StockSlot) {
+            stock = i;
+            canDeal = !position.piles[i].empty();
+        } else if (position.types[i] == TableauSlot) {
+            tableau.push_back(i);
+            if (emptyTableau < 0 && position.piles[i].empty())
+                emptyTableau = i;
+        }
+    }
+
+    std::vector<SolverMove> sameSuit;
+    std::vector<SolverMove> revealing;
+    std::vector<SolverMove> others;
+    std::vector<SolverMove> toEmpty;
+    std::vector<SolverMove> seatedMoves;
+
+    for (int from : tableau) {
+        const SolverPile &pile = position.piles[from];
+        if (pile.empty())
+            continue;
+
+        // Spider moves only runs of the same suit, Scorpion moves any
+        // card facing up with all cards on top of it
+        size_t first = pile.size() - 1;
+        while (first > 0 && faceUp(pile[first - 1])) {
+            if (!m_scorpion && (!SolverCard::sameSuit(pile[first - 1], pile[first])
+                                || rank(pile[first - 1]) != rank(pile[first]) + 1))
+                break;
+            first--;
+        }
+
+        for (size_t i = first; i < pile.size(); i++) {
+            quint8 card = pile[i];
+            bool reveals = i > 0 && !faceUp(pile[i - 1]);
+            bool seated = i > 0 && faceUp(pile[i - 1]) && rank(pile[i - 1]) == rank(card) + 1;
+            bool seatedOnSuit = seated && SolverCard::sameSuit(pile[i - 1], card);
+
+            for (int target : tableau) {
+                const SolverPile &targetPile = position.piles[target];
+                if (target == from)
+                    continue;
+                SolverMove move = { SolverMove::Transfer, (quint8)from, (quint8)target,
+                                    (quint8)(pile.size() - i) };
+                if (targetPile.empty()) {
+                    // Empty slots are alike only after all cards have been dealt
+                    if (!canDeal && (target != emptyTableau || i == 0))
+                        continue;
+                    if (m_scorpion && rank(card) != RankKing)
+                        continue;
+                    toEmpty.push_back(move);
+                    continue;
+                }
+
+                quint8 top = targetPile.back();
+                if (rank(top) != rank(card) + 1)
+                    continue;
+                bool onSuit = SolverCard::sameSuit(top, card);
+                if (m_scorpion && !onSuit)
+                    continue;
+                // Moving between two equally good places only helps if the
+                // card below is needed, try those last
+                if (seatedOnSuit || (seated && !onSuit))
+                    seatedMoves.push_back(move);
+                else if (onSuit)
+                    sameSuit.push_back(move);
+                else
+                    (reveals ? revealing : others).push_back(move);
+            }
+        }
+    }
+
+    moves.clear();
+    moves.insert(moves.end(), sameSuit.begin(), sameSuit.end());
+    moves.insert(moves.end(), revealing.begin(), revealing.end());
+    moves.insert(moves.end(), others.begin(), others.end());
+    moves.insert(moves.end(), toEmpty.begin(), toEmpty.end());
+    moves.insert(moves.end(), seatedMoves.begin(), seatedMoves.end());
+
+    // Spider does not allow dealing while there are empty slots
+    if (canDeal && (m_scorpion || emptyTableau < 0)) {
+        SolverMove move = { SolverMove::Deal, (quint8)stock, (quint8)stock,
+                            (quint8)position.piles[stock].size() };
+        moves.push_back(move);
+    }
+}
+
+void SpiderSolver::apply(SolverPosition &position, const SolverMove &move) const
+{
+    SolverPile &from = position.piles[move.from];
+    if (move.kind == SolverMove::Transfer) {
+        SolverPile &to = position.piles[move.to];
+        to.insert(to.end(), from.end() - move.count, from.end());
+        from.erase(from.end() - move.count, from.end());
+        flipTop(from);
+        removeCompleteSuit(position, move.to);
+    } else if (move.kind == SolverMove::Deal) {
+        // One card to each slot from left to right as long as there are cards
+        for (size_t i = 0; i < position.piles.size() && !from.empty(); i++) {
+            if (position.types[i] == TableauSlot) {
+                position.piles[i].push_back(from.back() | FaceUp);
+                from.pop_back();
+            }
+        }
+        for (size_t i = 0; i < position.piles.size(); i++) {
+            if (position.types[i] == TableauSlot)
+                removeCompleteSuit(position, i);
+        }
+    }
+}
+
+bool SpiderSolver::isWon(const SolverPosition &position) const
+{
+    for (size_t i = 0; i < position.piles.size(); i++) {
+        const SolverPile &pile = position.piles[i];
+        if (position.types[i] == FoundationSlot || pile.empty())
+            continue;
+        if (position.types[i] != TableauSlot || pile.size() != SuitLength || !isCompleteSuit(pile, 0))
+            return false;
+    }
+    return true;
+}
+
+void SpiderSolver::prepare(SolverPosition &position) const
+{
+    position.orderedTableau = true;
+}
+
+bool SpiderSolver::isCompleteSuit(const SolverPile &pile, size_t first) const
+{
+    if (pile.size() < first + SuitLength)
+        return false;
+    for (size_t i = 0; i < SuitLength; i++) {
+        quint8 card = pile[first + i];
+        if (!faceUp(card) || rank(card) != RankKing - (int)i
+                || !SolverCard::sameSuit(card, pile[first]))
+            return false;
+    }
+    return true;
+}
+
+void SpiderSolver::removeCompleteSuit(SolverPosition &position, int index) const
+{
+    SolverPile &pile = position.piles[index];
+    if (pile.size() < SuitLength || !isCompleteSuit(pile, pile.size() - SuitLength))
+        return;
+
+    for (size_t i = 0; i < position.piles.size(); i++) {
+        if (position.types[i] == FoundationSlot && position.piles[i].empty()) {
+            position.piles[i].assign(pile.end() - SuitLength, pile.end());
+            pile.erase(pile.end() - SuitLength, pile.end());
+            flipTop(pile);
+            return;
+        }
+    }
+}
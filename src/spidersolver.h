@@ -0,0 +1,47 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPIDERSOLVER_H
+#define SPIDERSOLVER_H
+
+#include "solver.h"
+
+/*
+ * Solver for Spider, Spiderette and Scorpion.
+ */
+class SpiderSolver : public Solver
+{
+public:
+    explicit SpiderSolver(const QString &name);
+
+    static bool supports(const QString &name);
+
+    void moves(const SolverPosition &position, std::vector<SolverMove> &moves) const;
+    void apply(SolverPosition &position, const SolverMove &move) const;
+    bool isWon(const SolverPosition &position) const;
+
+protected:
+    void prepare(SolverPosition &position) const;
+
+private:
+    bool isCompleteSuit(const SolverPile &pile, size_t first) const;
+    void removeCompleteSuit(SolverPosition &position, int pile) const;
+
+    bool m_scorpion;
+};
+
+#endif // SPIDERSOLVER_H
@@ -21,12 +21,16 @@
 #include <QColor>
 #include <QGuiApplication>
 #include <QQuickWindow>
+#include <QSGGeometryNode>
 #include <QSGSimpleRectNode>
 #include <QSGTexture>
+#include <QSGVertexColorMaterial>
 #include <QStyleHints>
 #include "table.h"
+#include "atlascache.h"
 #include "constants.h"
 #include "card.h"
+#include "cardbatchnode.h"
 #include "drag.h"
 #include "engine.h"
 #include "slot.h"
@@ -38,8 +42,43 @@ namespace {
 const qreal CardRatio = 79.0 / 123.0;
 const QMarginsF SlotMargins(3, 3, 3, 3);
 const QMarginsF SlotOutlineWidth(3, 3, 3, 3);
+const QColor SlotOutlineColor(Qt::gray);
+const QColor SlotBackgroundColor(Qt::darkGreen);
+const QColor PileEdgeColors[] = { QColor(Qt::lightGray), QColor(Qt::gray) };
+const int VerticesPerQuad = 6;
+
+// One edge is drawn below a pile for this many hidden cards
+const int CardsPerPileEdge = 4;
+const int MaximumPileEdges = 4;
+const qreal PileEdgeOffset = 0.02; // of card width
 const QColor DefaultHighlightColor(Qt::blue);
 const qreal DefaultHighlightOpacity = 0.25;
+const int RecentTableSizes = 4;
+
+// Pre-rendered textures must not push the current one out of the cache
+const qint64 PrerenderBudget = AtlasCache::MaximumSize / 2;
+
+void setQuad(QSGGeometry::ColoredPoint2D *vertices, const QRectF &rect, const QColor &color)
+{
+    uchar r = color.red(), g = color.green(), b = color.blue(), a = color.alpha();
+    vertices[0].set(rect.left(), rect.top(), r, g, b, a);
+    vertices[1].set(rect.right(), rect.top(), r, g, b, a);
+    vertices[2].set(rect.left(), rect.bottom(), r, g, b, a);
+    vertices[3] = vertices[2];
+    vertices[4] = vertices[1];
+    vertices[5].set(rect.right(), rect.bottom(), r, g, b, a);
+}
+
+QSGGeometryNode *createColoredNode()
+{
+    auto *node = new QSGGeometryNode();
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+    geometry->setDrawingMode(GL_TRIANGLES);
+    node->setGeometry(geometry);
+    node->setMaterial(new QSGVertexColorMaterial());
+    node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+    return node;
+}
 
 } // namespace
 
@@ -51,11 +90,19 @@ Table::Table(QQuickItem *parent)
     , m_sideMargin(0)
     , m_dirty(true)
     , m_dirtyCardSize(true)
-    , m_highlightedSlot(nullptr)
+    , m_dirtyHighlights(true)
+    , m_layoutCount(0)
     , m_highlightColor(DefaultHighlightColor)
+    , m_highlightTargets(false)
+    , m_tapToMove(false)
+    , m_movesId(0)
     , m_manager(this)
     , m_drag(nullptr)
+    , m_pressedCard(nullptr)
+    , m_recentTableSizesConf(Constants::ConfPath + QStringLiteral("/recentTableSizes"))
     , m_cardTexture(nullptr)
+    , m_cardImageCached(false)
+    , m_textureBudget(0)
 {
     setAcceptedMouseButtons(Qt::LeftButton);
     setFlag(QQuickItem::ItemClipsChildrenToShape);
@@ -69,6 +116,13 @@ Table::Table(QQuickItem *parent)
     connect(renderer, &TextureRenderer::textureRendered, this, &Table::handleCardTextureRendered);
     m_textureThread.start();
 
+    qRegisterMetaType<QList<QSize>>();
+    auto prerenderer = new TextureRenderer();
+    prerenderer->moveToThread(&m_prerenderThread);
+    connect(&m_prerenderThread, &QThread::finished, prerenderer, &TextureRenderer::deleteLater);
+    connect(this, &Table::doPrerenderCardTextures, prerenderer, &TextureRenderer::prerenderTextures);
+    m_prerenderThread.start(QThread::IdlePriority);
+
     auto engine = Engine::instance();
     connect(engine, &Engine::gameLoaded, this, &Table::update);
     connect(engine, &Engine::setExpansionToDown, this, &Table::handleSetExpansionToDown);
@@ -79,58 +133,191 @@ Table::Table(QQuickItem *parent)
     connect(this, &Table::heightChanged, this, &Table::setDirtyCardSize);
     connect(this, &Table::widthChanged, this, &Table::setDirtyCardSize);
     connect(this, &Table::doClick, engine, &Engine::click);
+    connect(this, &Table::doRequestMoves, engine, &Engine::requestMoves);
+    connect(engine, &Engine::gameStarted, this, &Table::handlePositionChanged);
+    connect(engine, &Engine::gameContinued, this, &Table::handlePositionChanged);
+    connect(engine, &Engine::moveEnded, this, &Table::handlePositionChanged);
+    connect(engine, &Engine::restoreCompleted, this, &Table::handlePositionChanged);
+    connect(engine, &Engine::legalMoves, this, &Table::handleLegalMoves);
 }
 
 Table::~Table()
 {
     m_textureThread.quit();
+    m_prerenderThread.quit();
     m_textureThread.wait();
+    m_prerenderThread.wait();
 }
 
 void Table::updatePolish()
 {
     if (m_dirtyCardSize)
         updateCardSize();
+    layoutSlots();
+
+    if (m_layoutCount > 0) {
+        qCDebug(lcTable) << "Laid out slots" << m_layoutCount << "times for this frame";
+        m_layoutCount = 0;
+    }
 }
 
-QSGNode *Table::getPaintNodeForSlot(Slot *slot)
+void Table::relayout(Slot *slot)
 {
-    auto target = QRectF(slot->x(), slot->y(), slot->width(), slot->height()) - SlotMargins;
-    QColor outlineColor(Qt::gray);
-    auto *node = new QSGSimpleRectNode(target, outlineColor);
-    QColor backgroundColor(Qt::darkGreen);
-    auto *innerNode = new QSGSimpleRectNode(target - SlotOutlineWidth, backgroundColor);
-    innerNode->setFlag(QSGNode::OwnedByParent);
-    node->appendChildNode(innerNode);
-    if (slot->highlighted() && slot->isEmpty()) {
-        auto child = new QSGSimpleRectNode(target, m_highlightColor);
-        child->setFlag(QSGNode::OwnedByParent);
-        node->appendChildNode(child);
+    // Slots are laid out once when the move ends or before the next frame
+    if (!m_dirtySlots.contains(slot))
+        m_dirtySlots.append(slot);
+    polish();
+}
+
+void Table::layoutSlots()
+{
+    for (Slot *slot : m_dirtySlots)
+        slot->updateLocations();
+    m_layoutCount += m_dirtySlots.count();
+    m_dirtySlots.clear();
+}
+
+void Table::updateSlotsNode(QSGGeometryNode *node)
+{
+    // Outline and background of every slot as two quads in one geometry
+    QSGGeometry *geometry = node->geometry();
+    geometry->allocate(m_slots.count() * 2 * VerticesPerQuad);
+    auto *vertices = geometry->vertexDataAsColoredPoint2D();
+    for (Slot *slot : m_slots) {
+        auto target = QRectF(slot->x(), slot->y(), slot->width(), slot->height()) - SlotMargins;
+        setQuad(vertices, target, SlotOutlineColor);
+        vertices += VerticesPerQuad;
+        setQuad(vertices, target - SlotOutlineWidth, SlotBackgroundColor);
+        vertices += VerticesPerQuad;
     }
-    return node;
+    node->markDirty(QSGNode::DirtyGeometry);
+}
+
+void Table::updateHighlightsNode(QSGGeometryNode *node)
+{
+    // One quad for every highlighted slot, vertex colors are premultiplied
+    qreal alpha = m_highlightColor.alphaF();
+    QColor color = QColor::fromRgbF(m_highlightColor.redF() * alpha, m_highlightColor.greenF() * alpha,
+                                    m_highlightColor.blueF() * alpha, alpha);
+    QVector<QRectF> targets;
+    for (Slot *slot : m_highlightedSlots) {
+        QRectF target;
+        if (slot->isEmpty())
+            target = QRectF(slot->x(), slot->y(), slot->width(), slot->height()) - SlotMargins;
+        else if (m_cardTexture)
+            target = slot->top()->mapRectToItem(this, slot->top()->boundingRect());
+        if (!target.isEmpty())
+            targets.append(target);
+    }
+
+    QSGGeometry *geometry = node->geometry();
+    geometry->allocate(targets.count() * VerticesPerQuad);
+    auto *vertices = geometry->vertexDataAsColoredPoint2D();
+    for (int i = 0; i < targets.count(); i++)
+        setQuad(vertices + i * VerticesPerQuad, targets[i], color);
+    node->markDirty(QSGNode::DirtyGeometry);
 }
 
 QSGNode *Table::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
 {
     auto *node = static_cast<QSGSimpleRectNode *>(oldNode);
-    if (!node || m_dirty) {
-        if (!node) {
-            QColor backgroundColor(Qt::darkGreen);
-            node = new QSGSimpleRectNode(boundingRect(), backgroundColor);
+    if (!node) {
+        QColor backgroundColor(Qt::darkGreen);
+        node = new QSGSimpleRectNode(boundingRect(), backgroundColor);
+        // Slots, pile edges, cards and highlights in this order
+        for (QSGNode *child : { (QSGNode *)createColoredNode(), (QSGNode *)createColoredNode(),
+                                (QSGNode *)new CardBatchNode(), (QSGNode *)createColoredNode() }) {
+            child->setFlag(QSGNode::OwnedByParent);
+            node->appendChildNode(child);
         }
-        if (m_dirty) {
-            node->setRect(boundingRect());
-            node->removeAllChildNodes();
+    }
+    auto *slotsNode = static_cast<QSGGeometryNode *>(node->childAtIndex(0));
+    auto *pilesNode = static_cast<QSGGeometryNode *>(node->childAtIndex(1));
+    auto *cardsNode = static_cast<CardBatchNode *>(node->childAtIndex(2));
+    auto *highlightsNode = static_cast<QSGGeometryNode *>(node->childAtIndex(3));
+
+    // Cards that are being dragged are drawn by Drag. Cards that are covered
+    // by two cards at the same position are not drawn at all, instead the
+    // depth of such a pile is shown with edges below its lowest drawn card.
+    QVector<Card *> cards;
+    QVector<QRectF> edges;
+    qreal offset = std::max(round(m_cardSize.width() * PileEdgeOffset), (qreal)1.0F);
+    for (Slot *slot : m_slots) {
+        int hidden = 0;
+        for (auto it = slot->constBegin(); it != slot->constEnd(); it++) {
+            if (slot->constEnd() - it > 2 && (*(it + 2))->position() == (*it)->position()) {
+                hidden++;
+                continue;
+            }
+            if (hidden > 0) {
+                QRectF rect = (*it)->mapRectToItem(this, (*it)->boundingRect());
+                int count = std::min((hidden + CardsPerPileEdge - 1) / CardsPerPileEdge, MaximumPileEdges);
+                for (int i = count; i > 0; i--)
+                    edges.append(rect.translated(i * offset, i * offset));
+                hidden = 0;
+            }
+            cards.append(*it);
         }
-        for (Slot *slot : m_slots) {
-            auto slotNode = getPaintNodeForSlot(slot);
-            slotNode->setFlag(QSGNode::OwnedByParent);
-            node->appendChildNode(slotNode);
+    }
+    bool reordered = cards != m_drawnCards;
+
+    if (m_dirty || edges != m_pileEdges) {
+        QSGGeometry *geometry = pilesNode->geometry();
+        geometry->allocate(edges.count() * VerticesPerQuad);
+        auto *vertices = geometry->vertexDataAsColoredPoint2D();
+        for (int i = 0; i < edges.count(); i++)
+            setQuad(vertices + i * VerticesPerQuad, edges[i], PileEdgeColors[i % 2]);
+        pilesNode->markDirty(QSGNode::DirtyGeometry);
+        m_pileEdges = edges;
+    }
+
+    // Slots change only when the layout changes
+    if (m_dirty) {
+        node->setRect(boundingRect());
+        updateSlotsNode(slotsNode);
+    }
+
+    QSGTexture *texture = cardTexture();
+    bool newTexture = cardsNode->texture() != texture;
+    if (m_dirty || reordered || newTexture) {
+        cardsNode->setTexture(texture);
+        cardsNode->setCount(texture ? cards.count() : 0);
+        for (int i = 0; i < cards.count(); i++)
+            cardsNode->setQuad(i, cards[i]->mapRectToItem(this, cards[i]->boundingRect()), cards[i]->sourceRect());
+        m_drawnCards = cards;
+    } else {
+        for (Card *card : m_dirtyCards) {
+            int index = cards.indexOf(card);
+            if (index >= 0)
+                cardsNode->setQuad(index, card->mapRectToItem(this, card->boundingRect()), card->sourceRect());
         }
     }
+    cardsNode->commit();
+
+    // Highlights follow the top cards of highlighted slots
+    bool highlightMoved = false;
+    for (Slot *slot : m_highlightedSlots) {
+        if (!slot->isEmpty() && m_dirtyCards.contains(slot->top())) {
+            highlightMoved = true;
+            break;
+        }
+    }
+    if (m_dirty || m_dirtyHighlights || reordered || newTexture || highlightMoved)
+        updateHighlightsNode(highlightsNode);
+
+    m_dirty = false;
+    m_dirtyHighlights = false;
+    m_dirtyCards.clear();
     return node;
 }
 
+void Table::updateCard(Card *card)
+{
+    m_dirtyCards.insert(card);
+    if (!preparing())
+        update();
+}
+
 qreal Table::minimumSideMargin() const
 {
     return m_minimumSideMargin;
@@ -211,6 +398,8 @@ void Table::setHighlightColor(QColor color)
     if (m_highlightColor != color) {
         m_highlightColor = color;
         emit highlightColorChanged();
+        m_dirtyHighlights = true;
+        update();
     }
 }
 
@@ -221,6 +410,62 @@ void Table::resetHighlightColor()
     setHighlightColor(color);
 }
 
+bool Table::highlightTargets() const
+{
+    return m_highlightTargets;
+}
+
+void Table::setHighlightTargets(bool highlightTargets)
+{
+    if (m_highlightTargets != highlightTargets) {
+        m_highlightTargets = highlightTargets;
+        emit highlightTargetsChanged();
+        handlePositionChanged();
+    }
+}
+
+bool Table::tapToMove() const
+{
+    return m_tapToMove;
+}
+
+void Table::setTapToMove(bool tapToMove)
+{
+    if (m_tapToMove != tapToMove) {
+        m_tapToMove = tapToMove;
+        emit tapToMoveChanged();
+        handlePositionChanged();
+    }
+}
+
+int Table::textureBudget() const
+{
+    return m_textureBudget;
+}
+
+void Table::setTextureBudget(int textureBudget)
+{
+    if (m_textureBudget != textureBudget) {
+        m_textureBudget = textureBudget;
+        emit textureBudgetChanged();
+        if (m_cardSize.isValid() && textureSize(m_cardSize) != m_cardImageSize)
+            emit doRenderCardTexture(textureSize(m_cardSize));
+    }
+}
+
+QVariantMap Table::atlasMemory()
+{
+    qint64 textureBytes = m_cardTexture ? (qint64)m_cardImageSize.width() * m_cardImageSize.height() * 4 : 0;
+    return QVariantMap {
+        { QStringLiteral("textureBytes"), textureBytes },
+        { QStringLiteral("imageBytes"), (qint64)m_cardImage.byteCount() },
+        { QStringLiteral("budgetBytes"), (qint64)m_textureBudget * 1024 * 1024 },
+        { QStringLiteral("textureWidth"), m_cardImageSize.width() },
+        { QStringLiteral("textureHeight"), m_cardImageSize.height() },
+        { QStringLiteral("cacheBytes"), AtlasCache::instance()->totalSize() },
+    };
+}
+
 qreal Table::sideMargin() const
 {
     return m_sideMargin;
@@ -268,10 +513,10 @@ bool Table::preparing() const
 
 QList<Slot *> Table::getSlotsFor(const Card *card, Slot *source)
 {
-    auto rect = mapRectFromItem(card, card->boundingRect());
+    auto rect = card->mapRectToItem(this, card->boundingRect());
     QMap<qreal, Slot *> results;
     for (Slot *slot : m_slots) {
-        QRectF children = mapRectFromItem(slot, slot->childrenRect());
+        QRectF children = mapRectFromItem(slot, slot->cardsRect());
         auto box = mapRectFromItem(slot, slot->boundingRect()).united(children);
         auto overlapped = rect.intersected(box);
         if (!overlapped.isEmpty())
@@ -287,14 +532,53 @@ QList<Slot *> Table::getSlotsFor(const Card *card, Slot *source)
     return sorted;
 }
 
+QList<Slot *> Table::getTargetsFor(Card *card, Slot *source) const
+{
+    QList<Slot *> targets;
+    int index = source->constFind(card) - source->constBegin();
+    for (const MoveData &move : m_legalMoves) {
+        if (move.from == source->id() && move.index == index) {
+            Slot *target = m_slots.value(move.to);
+            if (target)
+                targets.append(target);
+        }
+    }
+    return targets;
+}
+
+Slot *Table::getBestTargetFor(Card *card, Slot *source) const
+{
+    // Foundations first, then building on tableau, other moves are
+    // left for the player to decide
+    Slot *best = nullptr;
+    for (Slot *target : getTargetsFor(card, source)) {
+        if (target->type() == FoundationSlot)
+            return target;
+        if (!best && target->type() == TableauSlot && !target->isEmpty())
+            best = target;
+    }
+    return best;
+}
+
 void Table::highlight(Slot *slot)
 {
-    if (m_highlightedSlot != slot) {
-        if (m_highlightedSlot)
-            m_highlightedSlot->removeHighlight();
-        if (slot)
-            slot->highlight();
-        m_highlightedSlot = slot;
+    highlight(slot ? QList<Slot *>() << slot : QList<Slot *>());
+}
+
+void Table::highlight(const QList<Slot *> &slots)
+{
+    if (m_highlightedSlots != slots) {
+        for (Slot *slot : m_highlightedSlots) {
+            if (!slots.contains(slot))
+                slot->removeHighlight();
+        }
+        for (Slot *slot : slots) {
+            if (!m_highlightedSlots.contains(slot))
+                slot->highlight();
+        }
+        m_highlightedSlots = slots;
+        // All highlighted slots are drawn on the next paint
+        m_dirtyHighlights = true;
         update();
     }
 }
@@ -314,15 +598,19 @@ Slot *Table::slot(int id) const
 void Table::clear()
 {
     m_slots.clear();
-    m_highlightedSlot = nullptr;
+    m_dirtySlots.clear();
+    m_dirtyCards.clear();
+    m_drawnCards.clear();
+    m_pileEdges.clear();
+    m_highlightedSlots.clear();
+    m_legalMoves.clear();
     if (m_drag)
         m_drag->deleteLater();
     m_drag = nullptr;
+    m_pressedCard = nullptr;
     m_tableSize = QSizeF();
     m_cardSize = QSizeF();
-    setCardTexture(nullptr);
-    m_cardSizeInTexture = QSizeF();
-    m_cardImage = QImage();
+    // Card texture is kept so that cards stay visible until a new one is rendered
 }
 
 void Table::store(const QList<Card *> &cards)
@@ -330,11 +618,26 @@ void Table::store(const QList<Card *> &cards)
     m_manager.store(cards);
 }
 
+void Table::place(Slot *slot, const QList<Card *> &cards)
+{
+    m_manager.place(slot, cards);
+}
+
+void Table::unplace(Slot *slot, const QList<Card *> &cards)
+{
+    m_manager.unplace(slot, cards);
+}
+
 Drag *Table::drag(QMouseEvent *event, Card *card)
 {
     if (event->type() != QEvent::MouseButtonPress && m_drag && m_drag->card() == card)
         return m_drag;
 
+    if (event->type() == QEvent::MouseButtonPress && m_manager.isPlaced(card->slot()->top())) {
+        qCDebug(lcTable) << "Not starting drag of" << *card << "while engine has not accepted the previous move";
+        return nullptr;
+    }
+
     if (m_drag)
         m_drag->cancel();
 
@@ -385,7 +688,7 @@ void Table::handleSetExpansionToRight(int id, double expansion)
 
 void Table::handleSlotEmptied()
 {
-    m_dirty = true;
+    m_dirtyHighlights = true;
     if (!preparing())
         update();
 }
@@ -425,28 +728,13 @@ void Table::updateCardSize()
                                   << ", minimum side margin of " << m_minimumSideMargin
                                   << "and table size of " << m_tableSize;
 
-    qreal verticalSpace = width() - m_minimumSideMargin*2.0;
-    qreal horizontalSpace = height() - m_margin.height()*2.0;
-    qreal maximumWidth = (verticalSpace + m_margin.width()) / m_tableSize.width() - m_margin.width();
-    qreal maximumHeight = (horizontalSpace + m_margin.height()) / m_tableSize.height() - m_margin.height();
-    QSizeF newCardSize;
-    if ((maximumHeight * CardRatio) < maximumWidth) {
-        newCardSize = QSizeF(round(maximumHeight * CardRatio), round(maximumHeight));
-        m_cardMargin = QSizeF((maximumWidth - newCardSize.width()) / 2.0, 0.0);
-    } else {
-        newCardSize = QSizeF(round(maximumWidth), round(maximumWidth / CardRatio));
-        m_cardMargin = QSizeF(0.0, (maximumHeight - newCardSize.height()) / 2.0);
-    }
-
+    QSizeF newCardSize = calculateCardSize(QSizeF(width(), height()), m_tableSize, &m_cardMargin);
     if (m_cardSize != newCardSize) {
         m_cardSize = newCardSize;
-        m_cardImage = QImage();
-        QSize size(m_cardSize.width()*13, m_cardSize.height()*5);
-        emit doRenderCardTexture(size);
+        emit doRenderCardTexture(textureSize(m_cardSize));
     }
 
-    qCDebug(lcTable) << "Calculated maximum space of" << QSizeF(maximumWidth, maximumHeight)
-                        << "and card margin of" << m_cardMargin;
+    qCDebug(lcTable) << "Calculated card margin of" << m_cardMargin;
 
     if (m_maximumMargin.width() > 0 && m_cardMargin.width() + m_margin.width() > m_maximumMargin.width())
         m_cardMargin.setWidth(std::max(m_maximumMargin.width() - m_margin.width(), (qreal)0.0F));
@@ -474,13 +762,103 @@ void Table::updateCardSize()
         update();
 }
 
+QSize Table::textureSize(const QSizeF &cardSize) const
+{
+    QSize size(cardSize.width()*TextureRenderer::Columns, cardSize.height()*TextureRenderer::Rows);
+    qint64 budget = (qint64)m_textureBudget * 1024 * 1024;
+    qint64 bytes = (qint64)size.width() * size.height() * 4;
+    if (budget > 0 && bytes > budget) {
+        // Cards are drawn scaled up from a smaller texture
+        qreal scale = sqrt((qreal)budget / bytes);
+        size = QSize(std::max(floor(cardSize.width() * scale), 1.0) * TextureRenderer::Columns,
+                     std::max(floor(cardSize.height() * scale), 1.0) * TextureRenderer::Rows);
+    }
+    return size;
+}
+
+QSizeF Table::calculateCardSize(const QSizeF &area, const QSizeF &tableSize, QSizeF *cardMargin) const
+{
+    qreal verticalSpace = area.width() - m_minimumSideMargin*2.0;
+    qreal horizontalSpace = area.height() - m_margin.height()*2.0;
+    qreal maximumWidth = (verticalSpace + m_margin.width()) / tableSize.width() - m_margin.width();
+    qreal maximumHeight = (horizontalSpace + m_margin.height()) / tableSize.height() - m_margin.height();
+    QSizeF cardSize;
+    QSizeF margin;
+    if ((maximumHeight * CardRatio) < maximumWidth) {
+        cardSize = QSizeF(round(maximumHeight * CardRatio), round(maximumHeight));
+        margin = QSizeF((maximumWidth - cardSize.width()) / 2.0, 0.0);
+    } else {
+        cardSize = QSizeF(round(maximumWidth), round(maximumWidth / CardRatio));
+        margin = QSizeF(0.0, (maximumHeight - cardSize.height()) / 2.0);
+    }
+    if (cardMargin)
+        *cardMargin = margin;
+    return cardSize;
+}
+
+void Table::prerenderCardTextures()
+{
+    // Most recent table size first
+    QString current = QStringLiteral("%1x%2").arg(m_tableSize.width()).arg(m_tableSize.height());
+    QStringList recent = m_recentTableSizesConf.value().toStringList();
+    if (recent.isEmpty() || recent.first() != current) {
+        recent.removeAll(current);
+        recent.prepend(current);
+        while (recent.count() > RecentTableSizes)
+            recent.removeLast();
+        m_recentTableSizesConf.set(recent);
+    }
+
+    // Both orientations for every table, assumes that margins stay the same
+    QSizeF area(width(), height());
+    QList<QSize> sizes;
+    qint64 bytes = 0;
+    for (const QString &value : recent) {
+        QStringList parts = value.split(QLatin1Char('x'));
+        QSizeF tableSize(parts.value(0).toDouble(), parts.value(1).toDouble());
+        if (!tableSize.isValid() || tableSize.isEmpty())
+            continue;
+        for (const QSizeF &tableArea : { area, area.transposed() }) {
+            QSize size = textureSize(calculateCardSize(tableArea, tableSize));
+            if (size.isEmpty() || size == textureSize(m_cardSize) || sizes.contains(size))
+                continue;
+            bytes += (qint64)size.width() * size.height() * 4;
+            if (bytes > PrerenderBudget)
+                break;
+            sizes.append(size);
+        }
+        if (bytes > PrerenderBudget)
+            break;
+    }
+
+    if (!sizes.isEmpty()) {
+        qCDebug(lcTable) << "Pre-rendering card textures of sizes" << sizes;
+        emit doPrerenderCardTextures(sizes);
+    }
+}
+
 QSGTexture *Table::cardTexture()
 {
+    if (!m_cardTexture && m_cardImage.isNull() && m_cardImageCached) {
+        m_cardImage = AtlasCache::instance()->lookup(TextureRenderer::svgFile(), m_cardImageSize,
+                                                     QImage::Format_ARGB32_Premultiplied);
+        if (m_cardImage.isNull()) {
+            qCWarning(lcTable) << "Card texture is gone from cache, rendering it again";
+            m_cardImageSize = QSize();
+            m_cardImageCached = false;
+            emit doRenderCardTexture(textureSize(m_cardSize));
+        }
+    }
+
     if (!m_cardTexture && !m_cardImage.isNull()) {
         setCardTexture(window()->createTextureFromImage(m_cardImage));
-        connect(window(), &QQuickWindow::sceneGraphInvalidated, this, [this] {
-            setCardTexture(nullptr);
-        });
+        connect(window(), &QQuickWindow::sceneGraphInvalidated,
+                this, &Table::handleSceneGraphInvalidated, Qt::UniqueConnection);
+        // Cached textures are mapped back from disk if they are needed again
+        if (m_cardImageCached)
+            m_cardImage = QImage();
+        qCDebug(lcTable) << "Uploaded card texture of size" << m_cardImageSize
+                         << (m_cardImageCached ? "and released image" : "and kept image");
     }
     return m_cardTexture;
 }
@@ -494,14 +872,34 @@ void Table::setCardTexture(QSGTexture *texture)
 
 void Table::handleCardTextureRendered(QImage image, const QSize &size)
 {
-    QSize expectedSize(m_cardSize.width()*13, m_cardSize.height()*5);
-    if (expectedSize == size) {
-        m_cardImage = image;
-        m_cardSizeInTexture = m_cardSize;
-        setCardTexture(nullptr);
-        qCDebug(lcTable) << "New card texture rendered for card size of" << m_cardSize;
-        emit cardTextureUpdated();
+    if (textureSize(m_cardSize) != size)
+        return;
+
+    bool preview = image.size() != size;
+    if (preview && m_cardImageSize.isValid()) {
+        // Scaling the previous texture looks better than a preview
+        qCDebug(lcTable) << "Ignoring preview card texture of size" << image.size();
+        return;
     }
+
+    m_cardImage = image;
+    m_cardImageSize = image.size();
+    m_cardImageCached = !preview && AtlasCache::instance()->isValid();
+    m_cardSizeInTexture = QSizeF(image.width() / (qreal)TextureRenderer::Columns,
+                                 image.height() / (qreal)TextureRenderer::Rows);
+    setCardTexture(nullptr);
+    qCDebug(lcTable) << "New card texture rendered for card size of" << m_cardSize
+                     << "with" << m_cardSizeInTexture << "in texture";
+    emit cardTextureUpdated();
+    update();
+
+    if (!preview)
+        prerenderCardTextures();
+}
+
+void Table::handleSceneGraphInvalidated()
+{
+    setCardTexture(nullptr);
 }
 
 void Table::handleEngineFailure()
@@ -509,6 +907,23 @@ void Table::handleEngineFailure()
     setEnabled(false);
 }
 
+void Table::handlePositionChanged()
+{
+    // Moves are computed ahead so that they are known when a card is pressed
+    m_legalMoves.clear();
+    m_movesId++;
+    if (m_highlightTargets || m_tapToMove)
+        emit doRequestMoves(m_movesId);
+}
+
+void Table::handleLegalMoves(quint32 id, const MoveList &moves)
+{
+    if (id == m_movesId) {
+        qCDebug(lcTable) << "Received" << moves.count() << "legal moves";
+        m_legalMoves = moves;
+    }
+}
+
 Table::iterator Table::begin()
 {
     return m_slots.keyBegin();
@@ -519,10 +934,35 @@ Table::iterator Table::end()
     return m_slots.keyEnd();
 }
 
+Card *Table::cardAt(const QPointF &point) const
+{
+    // Topmost card first, slots are drawn in the order of their ids
+    for (auto it = m_slots.constEnd(); it-- != m_slots.constBegin();) {
+        Slot *slot = it.value();
+        Card *card = slot->cardAt(mapToItem(slot, point));
+        if (card)
+            return card;
+    }
+    return nullptr;
+}
+
 void Table::mousePressEvent(QMouseEvent *event)
 {
     qCDebug(lcMouse) << event << "for" << *this;
 
+    // Cards must be where they are drawn
+    layoutSlots();
+    Card *card = cardAt(event->pos());
+    if (card) {
+        qCDebug(lcMouse) << "Found card" << *card << "on press position";
+        if (drag(event, card)) {
+            m_pressedCard = card;
+            setKeepMouseGrab(true);
+            return;
+        }
+        // Card was dropped but engine has not accepted it yet
+    }
+
     for (Slot *slot : m_slots) {
         QPointF point = mapToItem(slot, event->pos());
         if (slot->contains(point)) {
@@ -533,10 +973,39 @@ void Table::mousePressEvent(QMouseEvent *event)
     }
 }
 
+void Table::mouseMoveEvent(QMouseEvent *event)
+{
+    qCDebug(lcMouse) << event << "for" << *this;
+
+    if (!m_pressedCard)
+        return;
+
+    auto drag = this->drag(event, m_pressedCard);
+    if (!drag) {
+        qCCritical(lcDrag) << "Can not handle mouse move! There is no drag ongoing!";
+        return;
+    }
+
+    drag->update(event);
+}
+
 void Table::mouseReleaseEvent(QMouseEvent *event)
 {
     qCDebug(lcMouse) << event << "for" << *this;
 
+    if (m_pressedCard) {
+        auto drag = this->drag(event, m_pressedCard);
+        m_pressedCard = nullptr;
+        setKeepMouseGrab(false);
+        if (!drag) {
+            qCCritical(lcDrag) << "Can not handle mouse release! There is no drag ongoing!";
+            return;
+        }
+
+        drag->finish(event);
+        return;
+    }
+
     auto styleHints = QGuiApplication::styleHints();
     if (!m_timer.hasExpired(styleHints->startDragTime())
             && (m_startPoint - event->pos()).manhattanLength() < styleHints->startDragDistance()) {
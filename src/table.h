@@ -18,18 +18,24 @@
 #ifndef TABLE_H
 #define TABLE_H
 
+#include <MGConfItem>
 #include <QColor>
 #include <QImage>
 #include <QMap>
 #include <QPointF>
+#include <QSet>
 #include <QSizeF>
 #include <QThread>
+#include <QVariantMap>
+#include <QVector>
 #include <QtQuick/QQuickItem>
 #include "engine.h"
 #include "enginedata.h"
 #include "manager.h"
 #include "slot.h"
 
+class Drag;
+class QSGGeometryNode;
 class QSGTexture;
 class QQuickWindow;
 class Table : public QQuickItem
@@ -47,14 +53,20 @@ class Table : public QQuickItem
                WRITE setMaximumVerticalMargin NOTIFY maximumVerticalMarginChanged);
     Q_PROPERTY(QColor highlightColor READ highlightColor WRITE setHighlightColor
                RESET resetHighlightColor NOTIFY highlightColorChanged)
+    Q_PROPERTY(bool highlightTargets READ highlightTargets WRITE setHighlightTargets
+               NOTIFY highlightTargetsChanged)
+    Q_PROPERTY(bool tapToMove READ tapToMove WRITE setTapToMove NOTIFY tapToMoveChanged)
+    Q_PROPERTY(int textureBudget READ textureBudget WRITE setTextureBudget NOTIFY textureBudgetChanged)
 
 public:
     explicit Table(QQuickItem *parent = nullptr);
     ~Table();
 
     void updatePolish();
-    QSGNode *getPaintNodeForSlot(Slot *slot);
+    void relayout(Slot *slot);
+    void layoutSlots();
     QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *);
+    void updateCard(Card *card);
     QSGTexture *cardTexture();
 
     qreal minimumSideMargin() const;
@@ -70,6 +82,13 @@ public:
     QColor highlightColor() const;
     void setHighlightColor(QColor color);
     void resetHighlightColor();
+    bool highlightTargets() const;
+    void setHighlightTargets(bool highlightTargets);
+    bool tapToMove() const;
+    void setTapToMove(bool tapToMove);
+    int textureBudget() const;
+    void setTextureBudget(int textureBudget);
+    Q_INVOKABLE QVariantMap atlasMemory();
 
     qreal sideMargin() const;
     QSizeF margin() const;
@@ -82,12 +101,17 @@ public:
     bool preparing() const;
 
     QList<Slot *> getSlotsFor(const Card *card, Slot *source);
+    QList<Slot *> getTargetsFor(Card *card, Slot *source) const;
+    Slot *getBestTargetFor(Card *card, Slot *source) const;
     void highlight(Slot *slot);
+    void highlight(const QList<Slot *> &slots);
 
     void addSlot(Slot *slot);
     Slot *slot(int id) const;
     void clear();
     void store(const QList<Card *> &cards);
+    void place(Slot *slot, const QList<Card *> &cards);
+    void unplace(Slot *slot, const QList<Card *> &cards);
     Drag *drag(QMouseEvent *event, Card *card);
 
     typedef QMap<int, Slot *>::key_iterator iterator;
@@ -105,10 +129,15 @@ signals:
     void maximumVerticalMarginChanged();
     void highlightColorChanged();
     void highlightOpacityChanged();
+    void highlightTargetsChanged();
+    void tapToMoveChanged();
+    void textureBudgetChanged();
     void cardTextureUpdated();
 
     void doClick(quint32 id, int slotId);
+    void doRequestMoves(quint32 id);
     void doRenderCardTexture(const QSize &size);
+    void doPrerenderCardTextures(const QList<QSize> &sizes);
 
 private slots:
     void handleCardTextureRendered(QImage image, const QSize &size);
@@ -118,11 +147,21 @@ private slots:
     void handleWidthChanged(double width);
     void handleHeightChanged(double height);
     void handleEngineFailure();
+    void handlePositionChanged();
+    void handleLegalMoves(quint32 id, const MoveList &moves);
+    void handleSceneGraphInvalidated();
 
 private:
+    QSize textureSize(const QSizeF &cardSize) const;
+    QSizeF calculateCardSize(const QSizeF &area, const QSizeF &tableSize, QSizeF *cardMargin = nullptr) const;
     void updateCardSize();
+    void updateSlotsNode(QSGGeometryNode *node);
+    void updateHighlightsNode(QSGGeometryNode *node);
+    void prerenderCardTextures();
     void updateIfNotPreparing();
+    Card *cardAt(const QPointF &point) const;
     void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
     void mouseReleaseEvent(QMouseEvent *event);
     void setCardTexture(QSGTexture *texture);
 
@@ -138,19 +177,35 @@ private:
     QSizeF m_cardMargin;
     bool m_dirty;
     bool m_dirtyCardSize;
-
-    Slot *m_highlightedSlot;
+    bool m_dirtyHighlights;
+    QList<Slot *> m_dirtySlots;
+    int m_layoutCount;
+
+    QSet<Card *> m_dirtyCards;
+    QVector<Card *> m_drawnCards;
+    QVector<QRectF> m_pileEdges;
+    QList<Slot *> m_highlightedSlots;
     QColor m_highlightColor;
+    bool m_highlightTargets;
+    bool m_tapToMove;
+    MoveList m_legalMoves;
+    quint32 m_movesId;
 
     QElapsedTimer m_timer;
     QPointF m_startPoint;
 
     Manager m_manager;
     Drag *m_drag;
+    Card *m_pressedCard;
 
     QThread m_textureThread;
+    QThread m_prerenderThread;
+    MGConfItem m_recentTableSizesConf;
     QSGTexture *m_cardTexture;
     QImage m_cardImage;
+    QSize m_cardImageSize;
+    bool m_cardImageCached;
+    int m_textureBudget;
 };
 
 QDebug operator<<(QDebug debug, const Table &);
@@ -15,33 +15,166 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QElapsedTimer>
 #include <QPainter>
+#include <QRunnable>
 #include <QSvgRenderer>
+#include <QThread>
+#include <QThreadStorage>
+#include <QVector>
+#include "atlascache.h"
 #include "constants.h"
 #include "logging.h"
 #include "texturerenderer.h"
 
+namespace {
+
+// Bands are at least this tall so that each one is worth a task
+const int MinimumBandHeight = 32;
+
+// Preview is rendered at this fraction of the requested size
+const int PreviewScale = 4;
+
+QThreadStorage<QSvgRenderer *> renderers;
+
+QSvgRenderer *renderer(const QString &svgFile)
+{
+    // QSvgRenderer is not thread safe, every thread parses its own copy
+    if (!renderers.hasLocalData())
+        renderers.setLocalData(new QSvgRenderer(svgFile));
+    return renderers.localData();
+}
+
+// The SVG has 13 columns and 5 rows of cards, but only the first three
+// cards of the last row are used. Those are moved to an extra column.
+const int SvgColumns = 13;
+const int SvgRows = 5;
+const int ExtraCards = 3;
+
+struct Tile {
+    QRect target;
+    QPointF offset;
+};
+
+QVector<Tile> layout(const QSize &cardSize, int bands)
+{
+    QVector<Tile> tiles;
+    int height = cardSize.height() * (SvgRows - 1);
+    for (int i = 0; i < bands; i++) {
+        int top = height * i / bands;
+        int bottom = height * (i + 1) / bands;
+        tiles.append(Tile{ QRect(0, top, cardSize.width() * SvgColumns, bottom - top), QPointF(0, -top) });
+    }
+    for (int i = 0; i < ExtraCards; i++) {
+        tiles.append(Tile{ QRect(QPoint(cardSize.width() * SvgColumns, cardSize.height() * i), cardSize),
+                           QPointF(-cardSize.width() * i, -cardSize.height() * (SvgRows - 1)) });
+    }
+    return tiles;
+}
+
+void renderTile(const QString &svgFile, QImage *image, const Tile &tile, const QSize &cardSize)
+{
+    // Paints straight to the pixels of the atlas, nothing to assemble afterwards
+    QImage part(image->scanLine(tile.target.top()) + tile.target.left() * 4,
+                tile.target.width(), tile.target.height(), image->bytesPerLine(), image->format());
+    QPainter painter(&part);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(part.rect(), Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QSizeF svgSize(cardSize.width() * SvgColumns, cardSize.height() * SvgRows);
+    renderer(svgFile)->render(&painter, QRectF(tile.offset, svgSize));
+}
+
+class TileRenderer : public QRunnable
+{
+public:
+    TileRenderer(const QString &svgFile, QImage *image, const Tile &tile, const QSize &cardSize)
+        : m_svgFile(svgFile)
+        , m_image(image)
+        , m_tile(tile)
+        , m_cardSize(cardSize)
+    {
+    }
+
+    void run() override
+    {
+        renderTile(m_svgFile, m_image, m_tile, m_cardSize);
+    }
+
+private:
+    QString m_svgFile;
+    QImage *m_image;
+    Tile m_tile;
+    QSize m_cardSize;
+};
+
+} // namespace
+
 TextureRenderer::TextureRenderer(QObject *parent)
     : QObject(parent)
 {
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
 }
 
-QSvgRenderer *TextureRenderer::renderer()
+QString TextureRenderer::svgFile()
 {
-    static QSvgRenderer *renderer = nullptr;
-    if (!renderer)
-        renderer = new QSvgRenderer(Constants::DataDirectory + QStringLiteral("/anglo.svg"));
-    return renderer;
+    return Constants::DataDirectory + QStringLiteral("/anglo.svg");
 }
 
 void TextureRenderer::renderTexture(const QSize &size)
 {
-    QImage image(size, QImage::Format_ARGB32_Premultiplied);
-    QPainter painter(&image);
-    painter.setCompositionMode(QPainter::CompositionMode_Source);
-    painter.fillRect(0, 0, size.width(), size.height(), Qt::transparent);
-    painter.setRenderHint(QPainter::Antialiasing);
-    renderer()->render(&painter);
-    qCDebug(lcTable) << "Drew new texture of size" << size;
+    QImage image = AtlasCache::instance()->lookup(svgFile(), size, QImage::Format_ARGB32_Premultiplied);
+    if (!image.isNull()) {
+        emit textureRendered(image, size);
+        return;
+    }
+
+    image = render(size, true);
     emit textureRendered(image, size);
+
+    AtlasCache::instance()->insert(svgFile(), image);
+}
+
+void TextureRenderer::prerenderTextures(const QList<QSize> &sizes)
+{
+    // Rendered atlases are only stored, they are mapped back when needed
+    for (const QSize &size : sizes) {
+        if (!AtlasCache::instance()->contains(svgFile(), size, QImage::Format_ARGB32_Premultiplied)) {
+            qCDebug(lcTable) << "Pre-rendering texture of size" << size;
+            AtlasCache::instance()->insert(svgFile(), render(size, false));
+        }
+    }
+}
+
+QImage TextureRenderer::render(const QSize &size, bool preview)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Bands and the extra column of the atlas are rendered concurrently
+    QSize cardSize(size.width() / Columns, size.height() / Rows);
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    int count = qBound(1, size.height() / MinimumBandHeight, m_pool.maxThreadCount() * 2);
+    for (const Tile &tile : layout(cardSize, count))
+        m_pool.start(new TileRenderer(svgFile(), &image, tile, cardSize));
+
+    // Quick preview is shown while the bands are still being rendered
+    QSize previewCardSize = preview ? cardSize / PreviewScale : QSize();
+    if (!previewCardSize.isEmpty()) {
+        QImage previewImage(previewCardSize.width() * Columns, previewCardSize.height() * Rows,
+                            QImage::Format_ARGB32_Premultiplied);
+        previewImage.fill(Qt::transparent);
+        for (const Tile &tile : layout(previewCardSize, 1))
+            renderTile(svgFile(), &previewImage, tile, previewCardSize);
+        qCDebug(lcTable) << "Drew preview texture of size" << previewImage.size() << "in" << timer.elapsed() << "ms";
+        emit textureRendered(previewImage, size);
+    }
+
+    m_pool.waitForDone();
+
+    qCDebug(lcTable) << "Drew new texture of size" << size << "in" << count << "bands in"
+                     << timer.elapsed() << "ms";
+    return image;
 }
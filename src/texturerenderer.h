@@ -21,23 +21,32 @@
 #include <QImage>
 #include <QObject>
 #include <QSize>
+#include <QThreadPool>
 
-class QSvgRenderer;
 class TextureRenderer : public QObject
 {
     Q_OBJECT
 
 public:
+    // Card cells in the atlas
+    static const int Columns = 14;
+    static const int Rows = 4;
+
     explicit TextureRenderer(QObject *parent = nullptr);
 
+    static QString svgFile();
+
 public slots:
     void renderTexture(const QSize &size);
+    void prerenderTextures(const QList<QSize> &sizes);
 
 signals:
     void textureRendered(QImage image, const QSize &size);
 
 private:
-    static QSvgRenderer *renderer();
+    QImage render(const QSize &size, bool preview);
+
+    QThreadPool m_pool;
 };
 
 #endif // TEXTURERENDERER_H
@@ -0,0 +1,139 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QMutexLocker>
+#include "logging.h"
+#include "watchdog.h"
+
+Watchdog *Watchdog::s_watchdog = nullptr;
+
+Watchdog::Watchdog(QObject *parent)
+    : QThread(parent)
+    , m_state(Idle)
+    , m_deadline(0)
+    , m_budget(DefaultBudget)
+    , m_quit(false)
+    , m_name(nullptr)
+    , m_depth(0)
+    , m_thread(SCM_BOOL_F)
+    , m_interrupt(SCM_BOOL_F)
+{
+    s_watchdog = this;
+    m_clock.start();
+}
+
+Watchdog::~Watchdog()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_condition.wakeAll();
+    }
+    wait();
+    if (s_watchdog == this)
+        s_watchdog = nullptr;
+}
+
+void Watchdog::setBudget(int msecs)
+{
+    // Negative value selects the default and zero turns the watchdog off
+    QMutexLocker locker(&m_mutex);
+    m_budget = msecs < 0 ? DefaultBudget : msecs;
+    qCDebug(lcEngine) << "Budget for Scheme calls is" << m_budget << "ms";
+}
+
+int Watchdog::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+void Watchdog::enter(const char *name, bool interactive)
+{
+    // Only the outermost call is timed
+    if (m_depth++ > 0)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_budget <= 0)
+        return;
+
+    if (scm_is_false(m_interrupt)) {
+        m_thread = scm_gc_protect_object(scm_current_thread());
+        m_interrupt = scm_gc_protect_object(
+            scm_c_make_gsubr("patience-watchdog-interrupt", 0, 0, 0, (void *)&Watchdog::interrupt));
+    }
+
+    if (!isRunning())
+        start(QThread::LowPriority);
+
+    m_name = name;
+    m_deadline = m_clock.elapsed() + (interactive ? qMin(m_budget, InteractiveBudget) : m_budget);
+    m_state = Armed;
+    m_condition.wakeAll();
+}
+
+bool Watchdog::leave()
+{
+    QMutexLocker locker(&m_mutex);
+    bool fired = m_state == Fired;
+    if (--m_depth == 0)
+        m_state = Idle;
+    return fired;
+}
+
+void Watchdog::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        if (m_state != Armed) {
+            m_condition.wait(&m_mutex);
+            continue;
+        }
+
+        qint64 remaining = m_deadline - m_clock.elapsed();
+        if (remaining > 0) {
+            m_condition.wait(&m_mutex, remaining);
+            continue;
+        }
+
+        m_state = Fired;
+        qCWarning(lcEngine) << "Interrupting" << m_name << "for exceeding its time budget";
+        locker.unlock();
+        scm_with_guile(&Watchdog::mark, this);
+        locker.relock();
+    }
+}
+
+SCM Watchdog::interrupt()
+{
+    // The call may have finished before engine thread got here
+    {
+        QMutexLocker locker(&s_watchdog->m_mutex);
+        if (s_watchdog->m_state != Fired)
+            return SCM_UNSPECIFIED;
+    }
+    return scm_throw(scm_from_locale_symbol("patience-watchdog"),
+                     scm_list_1(scm_from_utf8_string("Call took too long and was interrupted")));
+}
+
+void *Watchdog::mark(void *data)
+{
+    Watchdog *watchdog = static_cast<Watchdog *>(data);
+    scm_system_async_mark_for_thread(watchdog->m_interrupt, watchdog->m_thread);
+    return nullptr;
+}
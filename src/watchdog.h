@@ -0,0 +1,80 @@
+/*
+ * Patience Deck is a collection of patience games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <libguile.h>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+/*
+ * Interrupts Scheme calls that take too long. Engine thread tells when
+ * it enters and leaves Guile and the watchdog thread marks an async for
+ * engine thread when the budget runs out. The async throws at the next
+ * point where Guile runs asyncs, which is caught like any other Scheme
+ * error. Calls that are stuck in C code are not interrupted.
+ */
+class Watchdog : public QThread
+{
+    Q_OBJECT
+
+public:
+    static const int DefaultBudget = 5000;
+    static const int InteractiveBudget = 1000;
+
+    explicit Watchdog(QObject *parent = nullptr);
+    ~Watchdog();
+
+    void setBudget(int msecs);
+    int budget() const;
+
+    void enter(const char *name, bool interactive);
+    bool leave();
+
+protected:
+    void run() override;
+
+private:
+    enum State {
+        Idle,
+        Armed,
+        Fired,
+    };
+
+    static SCM interrupt();
+    static void *mark(void *data);
+
+    static Watchdog *s_watchdog;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+    QElapsedTimer m_clock;
+    State m_state;
+    qint64 m_deadline;
+    int m_budget;
+    bool m_quit;
+    const char *m_name;
+    int m_depth;
+    SCM m_thread;
+    SCM m_interrupt;
+};
+
+#endif // WATCHDOG_H
@@ -0,0 +1,63 @@
+TEMPLATE = app
+TARGET = seed-classifier
+CONFIG += link_pkgconfig
+PKGCONFIG += guile-2.2
+
+QT += core
+
+DEFINES += \
+    DATADIR=games \
+    ENGINE_EXERCISER=1
+
+INCLUDEPATH += ../../src/
+
+SOURCES += \
+    src/classifier.cpp \
+    src/seedclassifier.cpp \
+    ../../src/callstats.cpp \
+    ../../src/dealrater.cpp \
+    ../../src/engine.cpp \
+    ../../src/engineclone.cpp \
+    ../../src/enginesolver.cpp \
+    ../../src/interface.cpp \
+    ../../src/klondikesolver.cpp \
+    ../../src/legalmoves.cpp \
+    ../../src/logging.cpp \
+    ../../src/positionanalyzer.cpp \
+    ../../src/seeddatabase.cpp \
+    ../../src/solver.cpp \
+    ../../src/solvercache.cpp \
+    ../../src/spidersolver.cpp \
+    ../../src/watchdog.cpp
+
+HEADERS += \
+    src/seedclassifier.h \
+    ../../src/callstats.h \
+    ../../src/dealrater.h \
+    ../../src/engine.h \
+    ../../src/engine_p.h \
+    ../../src/engineclone.h \
+    ../../src/enginedata.h \
+    ../../src/enginesolver.h \
+    ../../src/interface.h \
+    ../../src/klondikesolver.h \
+    ../../src/legalmoves.h \
+    ../../src/logging.h \
+    ../../src/positionanalyzer.h \
+    ../../src/seeddatabase.h \
+    ../../src/solver.h \
+    ../../src/solvercache.h \
+    ../../src/spidersolver.h \
+    ../../src/watchdog.h
+
+games.files = $$files(../../aisleriot/games/*.scm)
+games.files -= ../../aisleriot/games/api.scm
+games.files -= ../../aisleriot/games/card-monkey.scm
+games.files -= ../../aisleriot/games/template.scm
+games.files -= ../../aisleriot/games/test.scm
+games.path = games/
+
+api.files = ../../aisleriot/games/api.scm
+api.path = games/aisleriot/
+
+INSTALLS += games api
@@ -0,0 +1,172 @@
+/*
+ * Seed classifier for Patience Deck games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include "engine.h"
+#include "engine_p.h"
+#include "enginesolver.h"
+#include "seedclassifier.h"
+
+SeedClassifier::SeedClassifier()
+{
+}
+
+int SeedClassifier::run(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Tool to classify Patience Deck seeds");
+    parser.addHelpOption();
+    parser.addOptions({
+        {{"g", "game"}, "Game file name to load", "filename"},
+        {{"f", "first"}, "First seed to classify", "seed", "0"},
+        {{"c", "count"}, "Number of seeds to classify", "count", "1000"},
+        {"shard", "Classify only shard k of n of the seeds", "k/n"},
+        {"nodes", "Search node limit per seed", "nodes"},
+        {"time", "Search time limit per seed", "msecs"},
+        {{"o", "output"}, "Output file", "filename"},
+        {"merge", "Merge the given seed databases into output"},
+    });
+    parser.addPositionalArgument("inputs", "Seed databases to merge", "[inputs...]");
+    parser.process(arguments);
+
+    if (parser.isSet("merge")) {
+        if (!parser.isSet("output") || parser.positionalArguments().isEmpty()) {
+            qWarning() << "Merging needs output and inputs";
+            return 1;
+        }
+        return SeedDatabase::merge(parser.value("output"), parser.positionalArguments()) ? 0 : 1;
+    }
+
+    bool ok = true;
+    quint32 first = parser.value("first").toUInt(&ok);
+    quint32 count = ok ? parser.value("count").toUInt(&ok) : 0;
+    if (!ok) {
+        qWarning() << "Invalid seed range";
+        return 1;
+    }
+
+    QString output;
+    if (parser.isSet("shard")) {
+        QStringList parts = parser.value("shard").split('/');
+        quint32 shard = parts.value(0).toUInt(&ok);
+        quint32 shards = ok ? parts.value(1).toUInt(&ok) : 0;
+        if (!ok || parts.count() != 2 || shards == 0 || shard >= shards) {
+            qWarning() << "Invalid shard" << parser.value("shard");
+            return 1;
+        }
+        // Contiguous ranges so that shards can be merged in any order
+        quint32 size = (count + shards - 1) / shards;
+        quint32 start = qMin(count, shard * size);
+        first += start;
+        count = qMin(size, count - start);
+        output = QStringLiteral("-%1").arg(shard);
+    }
+
+    Solver::Limits limits;
+    if (parser.isSet("nodes"))
+        limits.nodes = parser.value("nodes").toULongLong();
+    if (parser.isSet("time"))
+        limits.msecs = parser.value("time").toLongLong();
+
+    QString gameFile = parser.isSet("game") ? parser.value("game") : QStringLiteral("klondike.scm");
+    if (parser.isSet("output"))
+        output = parser.value("output");
+    else
+        output = QFileInfo(gameFile).completeBaseName() + output + QStringLiteral(".seeds");
+
+    return classify(gameFile, first, count, limits, output) ? 0 : 1;
+}
+
+bool SeedClassifier::classify(const QString &gameFile, quint32 first, quint32 count,
+                              const Solver::Limits &limits, const QString &output)
+{
+    auto engine = Engine::instance();
+    auto d = EnginePrivate::instance();
+    QDir directory("games");
+    engine->initWithDirectory(directory.absolutePath());
+    engine->loadGame(gameFile, false);
+    if (d->m_state != EnginePrivate::LoadedState) {
+        qWarning() << "Could not load" << gameFile;
+        return false;
+    }
+
+    GameOptionList options = d->getGameOptions();
+    Solver *solver = Solver::create(gameFile, options);
+    qDebug() << "Classifying" << count << "seeds of" << gameFile << "starting from" << first
+             << "using" << (solver ? "native" : "generic") << "solver";
+
+    QVector<SeedDatabase::Record> records;
+    records.reserve(count);
+    int solvable = 0;
+    int unsolvable = 0;
+    for (quint32 i = 0; i < count; i++) {
+        SeedDatabase::Record record = classifySeed(first + i, solver, limits);
+        if (record.classification == SeedDatabase::Solvable)
+            solvable++;
+        else if (record.classification == SeedDatabase::Unsolvable)
+            unsolvable++;
+        records.append(record);
+        if ((i + 1) % 100 == 0)
+            qDebug() << "Classified" << i + 1 << "seeds";
+    }
+    delete solver;
+
+    qDebug() << "Solvable:" << solvable << "unsolvable:" << unsolvable
+             << "unknown:" << count - solvable - unsolvable;
+    return SeedDatabase::write(output, SeedDatabase::optionsMask(options), first, records);
+}
+
+SeedDatabase::Record SeedClassifier::classifySeed(quint32 seed, Solver *solver,
+                                                  const Solver::Limits &limits)
+{
+    auto engine = Engine::instance();
+    auto d = EnginePrivate::instance();
+    d->m_seed = seed;
+    engine->startEngine(false);
+
+    // Engine picks another seed if there are no moves in the beginning,
+    // so this seed can never be played
+    if (d->m_seed != seed)
+        return { SeedDatabase::Unsolvable, 0 };
+
+    Solver::Outcome outcome;
+    quint64 nodes;
+    if (solver) {
+        SolverPosition position;
+        if (!SolverPosition::fromSlots(d->m_cardSlots, d->m_slotTypes, &position))
+            return { SeedDatabase::Unknown, 0 };
+        Solver::Result result = solver->solve(position, limits);
+        outcome = result.outcome;
+        nodes = result.nodes;
+    } else {
+        EngineSolver::Result result = EngineSolver(d).solve(limits);
+        outcome = result.outcome;
+        nodes = result.nodes;
+    }
+
+    switch (outcome) {
+    case Solver::Solvable:
+        return { SeedDatabase::Solvable, SeedDatabase::quantise(nodes) };
+    case Solver::Unsolvable:
+        return { SeedDatabase::Unsolvable, SeedDatabase::quantise(nodes) };
+    default:
+        return { SeedDatabase::Unknown, SeedDatabase::quantise(nodes) };
+    }
+}
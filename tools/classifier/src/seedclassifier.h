@@ -0,0 +1,38 @@
+/*
+ * Seed classifier for Patience Deck games.
+ * Copyright (C) 2021 Tomi Leppänen
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEEDCLASSIFIER_H
+#define SEEDCLASSIFIER_H
+
+#include <QStringList>
+#include "seeddatabase.h"
+#include "solver.h"
+
+class SeedClassifier
+{
+public:
+    SeedClassifier();
+
+    int run(const QStringList &arguments);
+
+private:
+    bool classify(const QString &gameFile, quint32 first, quint32 count,
+                  const Solver::Limits &limits, const QString &output);
+    SeedDatabase::Record classifySeed(quint32 seed, Solver *solver, const Solver::Limits &limits);
+};
+
+#endif // SEEDCLASSIFIER_H
@@ -17,17 +17,41 @@ DISTFILES += \
 SOURCES += \
     src/exerciser.cpp \
     src/helper.cpp \
+    ../../src/callstats.cpp \
+    ../../src/dealrater.cpp \
     ../../src/engine.cpp \
+    ../../src/engineclone.cpp \
+    ../../src/enginesolver.cpp \
     ../../src/interface.cpp \
-    ../../src/logging.cpp
+    ../../src/klondikesolver.cpp \
+    ../../src/legalmoves.cpp \
+    ../../src/logging.cpp \
+    ../../src/positionanalyzer.cpp \
+    ../../src/seeddatabase.cpp \
+    ../../src/solver.cpp \
+    ../../src/solvercache.cpp \
+    ../../src/spidersolver.cpp \
+    ../../src/watchdog.cpp
 
 HEADERS += \
     src/helper.h \
+    ../../src/callstats.h \
+    ../../src/dealrater.h \
     ../../src/engine.h \
     ../../src/engine_p.h \
+    ../../src/engineclone.h \
     ../../src/enginedata.h \
+    ../../src/enginesolver.h \
     ../../src/interface.h \
-    ../../src/logging.h
+    ../../src/klondikesolver.h \
+    ../../src/legalmoves.h \
+    ../../src/logging.h \
+    ../../src/positionanalyzer.h \
+    ../../src/seeddatabase.h \
+    ../../src/solver.h \
+    ../../src/solvercache.h \
+    ../../src/spidersolver.h \
+    ../../src/watchdog.h
 
 games.files = $$files(../../aisleriot/games/*.scm)
 games.files -= ../../aisleriot/games/api.scm
@@ -31,8 +31,10 @@ Item {
                          "seven", "eight", "nine", "ten", "jack", "queen", "king"]
     property var suits: ["clubs", "diamonds", "hearts", "spades"]
     property int score
+    property int hintId
 
     function quit() {
+        helper.printStats()
         Qt.quit()
     }
 
@@ -104,7 +106,7 @@ Item {
     Timer {
         id: newMove
         interval: 0
-        onTriggered: helper.engine.getHint()
+        onTriggered: helper.engine.getHint(++hintId)
     }
 
     Connections {
@@ -126,11 +128,19 @@ Item {
 
         function onGameStarted() {
             console.log("Game started with seed", helper.getSeed())
-            newMove.start()
+            console.log("There are", helper.legalMoves().length, "legal moves")
+            if (helper.solveRequested()) {
+                helper.solve()
+                quit()
+            } else {
+                newMove.start()
+            }
         }
 
-        function onHint(hint) {
-            parseAndActOnHint(hint)
+        function onHint(id, hint) {
+            if (id === hintId) {
+                parseAndActOnHint(hint)
+            }
         }
 
         function onMoveEnded() {
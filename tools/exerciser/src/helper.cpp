@@ -19,12 +19,19 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
+#include <QJsonDocument>
+#include <QTextStream>
 #include "helper.h"
 #include "engine.h"
 #include "engine_p.h"
+#include "enginesolver.h"
+#include "legalmoves.h"
+#include "solver.h"
 
 EngineHelper::EngineHelper()
     : QObject(nullptr)
+    , m_solve(false)
+    , m_stats(false)
 {
     auto engine = Engine::instance();
     connect(engine, &Engine::clearData, this, &EngineHelper::handleClearData);
@@ -46,9 +53,15 @@ bool EngineHelper::parseArgs()
     parser.addOptions({
         {{"g", "game"}, "Game file name to load", "filename"},
         {{"s", "seed"}, "Seed to use", "seed"},
+        {"solve", "Run native solver on the deal instead of following hints"},
+        {"stats", "Print statistics of Scheme calls as JSON when finished"},
     });
     parser.process(QCoreApplication::arguments());
 
+    m_solve = parser.isSet("solve");
+    m_stats = parser.isSet("stats");
+    EnginePrivate::instance()->setCallStatsEnabled(m_stats);
+
     if (parser.isSet("seed")) {
         bool ok;
         EnginePrivate::instance()->m_seed = parser.value("seed").toULongLong(&ok);
@@ -89,6 +102,52 @@ quint32 EngineHelper::getSeed() const
     return static_cast<quint32>(EnginePrivate::instance()->m_seed);
 }
 
+void EngineHelper::printStats()
+{
+    if (!m_stats)
+        return;
+
+    QJsonDocument document = QJsonDocument::fromVariant(EnginePrivate::instance()->getCallStats());
+    QTextStream(stdout) << document.toJson(QJsonDocument::Indented);
+}
+
+bool EngineHelper::solveRequested() const
+{
+    return m_solve;
+}
+
+void EngineHelper::solve()
+{
+    auto engine = EnginePrivate::instance();
+    Solver *solver = Solver::create(engine->m_gameFile, engine->getGameOptions());
+    if (!solver) {
+        qDebug() << "No native solver for" << engine->m_gameFile << "using generic solver";
+        EngineSolver::Result result = EngineSolver(engine).solve(Solver::Limits());
+        qDebug() << "Solver outcome:" << result.outcome << "nodes:" << result.nodes
+                 << "dead ends:" << result.deadEnds << "moves:" << result.depth
+                 << "time:" << result.msecs << "ms";
+        return;
+    }
+
+    SolverPosition position;
+    if (!SolverPosition::fromSlots(engine->m_cardSlots, engine->m_slotTypes, &position)) {
+        qDebug() << "Could not convert the deal for solver";
+        delete solver;
+        return;
+    }
+
+    Solver::Result result = solver->solve(position, Solver::Limits());
+    qDebug() << "Solver outcome:" << result.outcome << "nodes:" << result.nodes
+             << "dead ends:" << result.deadEnds << "moves:" << result.depth
+             << "time:" << result.msecs << "ms";
+
+    Solver::Estimate estimate = solver->estimate(position, 20, Solver::Limits(), getSeed());
+    qDebug() << "Winning chance:" << estimate.probability << "solved:" << estimate.solved
+             << "of" << estimate.samples << "unknown:" << estimate.unknown
+             << "nodes:" << estimate.nodes;
+    delete solver;
+}
+
 void EngineHelper::move(const QVariantMap &from, const QVariantMap &to)
 {
     auto engine = Engine::instance();
@@ -97,22 +156,23 @@ void EngineHelper::move(const QVariantMap &from, const QVariantMap &to)
         int slot = findSlot(card);
         if (slot != -1) {
             auto cards = getCards(slot, card);
-            if (engine->drag(-1, slot, cards)) {
-                int target;
-                if (isCard(to)) {
-                    auto card2 = toCard(to);
-                    target = findSlot(card2);
-                    qDebug() << "Moving" << card << "from slot" << slot
-                             << "onto" << card2 << "in slot" << target;
-                } else {
-                    target = findSlotByType(static_cast<Slots>(to.value("type").toInt()),
-                                            to.value("empty").toBool());
-                    qDebug() << "Moving" << card << "from slot" << slot
-                             << "to slot" << target;
-                }
-                if (target != -1)
-                    engine->drop(-1, slot, target, cards);
+            int index = EnginePrivate::instance()->m_cardSlots[slot].count() - cards.count();
+            int target;
+            if (isCard(to)) {
+                auto card2 = toCard(to);
+                target = findSlot(card2);
+                qDebug() << "Moving" << card << "from slot" << slot
+                         << "onto" << card2 << "in slot" << target;
+            } else {
+                target = findSlotByType(static_cast<Slots>(to.value("type").toInt()),
+                                        to.value("empty").toBool());
+                qDebug() << "Moving" << card << "from slot" << slot
+                         << "to slot" << target;
             }
+            if (target != -1 && !isLegalMove(slot, index, target))
+                qWarning() << "Move from slot" << slot << "to slot" << target << "is not listed as legal";
+            if (engine->drag(-1, slot, cards) && target != -1)
+                engine->drop(-1, slot, target, cards);
         }
     }
 }
@@ -130,6 +190,38 @@ void EngineHelper::click(const QVariantMap &clicked)
     }
 }
 
+QVariantList EngineHelper::legalMoves()
+{
+    QVariantList list;
+    MoveList moves;
+    if (!EnginePrivate::instance()->m_legalMoves->moves(&moves))
+        return list;
+    for (const MoveData &move : moves) {
+        QVariantMap map;
+        map.insert(QStringLiteral("from"), move.from);
+        map.insert(QStringLiteral("index"), move.index);
+        map.insert(QStringLiteral("to"), move.to);
+        list.append(map);
+    }
+    return list;
+}
+
+bool EngineHelper::isLegalMove(int from, int index, int to)
+{
+    auto engine = EnginePrivate::instance();
+    if (!engine->hasFeature(EnginePrivate::FeatureDroppable))
+        return true; // Moves are not known
+
+    MoveList moves;
+    if (!engine->m_legalMoves->moves(&moves))
+        return false;
+    for (const MoveData &move : moves) {
+        if (move.from == from && move.index == index && move.to == to)
+            return true;
+    }
+    return false;
+}
+
 bool EngineHelper::isCard(const QVariantMap &map)
 {
     return map.contains("rank") && map.contains("suit");
@@ -33,8 +33,12 @@ public:
     Engine *engine() const;
     Q_INVOKABLE bool parseArgs();
     Q_INVOKABLE quint32 getSeed() const;
+    Q_INVOKABLE bool solveRequested() const;
+    Q_INVOKABLE void solve();
+    Q_INVOKABLE void printStats();
     Q_INVOKABLE void move(const QVariantMap &from, const QVariantMap &to);
     Q_INVOKABLE void click(const QVariantMap &clicked);
+    Q_INVOKABLE QVariantList legalMoves();
 
     enum Slots : int {
         Unknown,
@@ -58,6 +62,9 @@ private:
     int findSlot(const CardData &needle);
     int findSlotByType(Slots type, bool emptyRequired);
     CardList getCards(int slot, const CardData &first);
+    bool isLegalMove(int from, int index, int to);
 
     QHash<int, Slots> m_slotTypes;
+    bool m_solve;
+    bool m_stats;
 };